@@ -0,0 +1,82 @@
+/**
+ * @file AdcCalibration.h
+ * @brief Calibrated ADC1 raw-to-millivolt conversion
+ * @author Yahya
+ *
+ * Characterizes ADC1 once at boot from the calibration stored in eFuse
+ * (two-point values when present, otherwise the factory Vref) and expands
+ * the curve into a 4096-entry millivolt table in RAM. Every light sensor
+ * conversion afterwards is a single table load, and the 12 dB attenuation
+ * nonlinearity is handled by the characterization instead of a straight
+ * 3.3 V / 4095 scale.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <esp_adc_cal.h>
+#include "Lys.h"
+
+// Calibration Configuration
+#define ADC_DEFAULT_VREF 1100   // mV, used only when eFuse holds no calibration
+
+class AdcCalibration {
+private:
+    uint16_t millivolts[ADC_MAX_VALUE + 1] = {};
+    esp_adc_cal_value_t source = ESP_ADC_CAL_VAL_DEFAULT_VREF;
+
+public:
+    /**
+     * @brief Characterize ADC1 and build the lookup table
+     * Must run after the attenuation/width are fixed and before sampling.
+     */
+    void begin() {
+        esp_adc_cal_characteristics_t chars;
+        source = esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTENUATION, ADC_RESOLUTION,
+                                          ADC_DEFAULT_VREF, &chars);
+
+        for (uint32_t raw = 0; raw <= ADC_MAX_VALUE; raw++) {
+            millivolts[raw] = esp_adc_cal_raw_to_voltage(raw, &chars);
+        }
+
+        const char* name = source == ESP_ADC_CAL_VAL_EFUSE_TP   ? "eFuse two-point"
+                         : source == ESP_ADC_CAL_VAL_EFUSE_VREF ? "eFuse Vref"
+                                                                : "default Vref";
+        Serial.printf("ADC calibration: %s, full scale %u mV\n", name, millivolts[ADC_MAX_VALUE]);
+    }
+
+    /**
+     * @brief Calibrated voltage of a raw 12-bit reading
+     * @param raw ADC value (0-4095)
+     * @return Millivolts
+     */
+    uint16_t toMillivolts(uint16_t raw) const {
+        return millivolts[raw > ADC_MAX_VALUE ? ADC_MAX_VALUE : raw];
+    }
+
+    /**
+     * @brief Calibrated voltage of a filtered Q4 reading
+     * Interpolates between neighbouring table entries so the extra
+     * resolution from oversampling is not thrown away.
+     * @param q4 Filtered value with LIGHT_FRAC_BITS fraction bits
+     * @return Millivolts
+     */
+    uint16_t toMillivoltsQ4(uint16_t q4) const {
+        uint16_t index = q4 >> LIGHT_FRAC_BITS;
+        if (index >= ADC_MAX_VALUE) {
+            return millivolts[ADC_MAX_VALUE];
+        }
+
+        uint32_t frac = q4 & ((1 << LIGHT_FRAC_BITS) - 1);
+        uint32_t lo = millivolts[index];
+        uint32_t hi = millivolts[index + 1];
+        return lo + (((hi - lo) * frac + (1 << (LIGHT_FRAC_BITS - 1))) >> LIGHT_FRAC_BITS);
+    }
+
+    /**
+     * @brief Which calibration the table was built from
+     */
+    esp_adc_cal_value_t calibrationSource() const {
+        return source;
+    }
+};
@@ -0,0 +1,128 @@
+/**
+ * @file AxisLink.h
+ * @brief Axis positions reported back by the Raspberry Pi
+ * @author Yahya
+ *
+ * The motor daemon answers the SUN_DIR stream with one line per second on
+ * the same UART:
+ *
+ *   AXIS:<azimuth>,<elevation>
+ *
+ * azimuth is the net stepper position in steps (clockwise positive),
+ * elevation the servo angle in degrees. Received bytes are assembled into
+ * lines in a fixed buffer and each valid line is published to a snapshot
+ * ring, so readers never block the UART and never see a torn pair.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "SnapshotRing.h"
+
+// Axis Link Configuration
+#define AXIS_LINE_MAX           32
+#define AXIS_RING_SIZE          4
+#define AXIS_STALE_MS           5000    // Positions older than this are reported as unknown
+
+/**
+ * @brief Latest axis positions from the Pi
+ */
+struct AxisSnapshot {
+    uint32_t sequence;
+    uint32_t timestampMs;       // millis() when the line was received
+    int32_t azimuth;            // Stepper steps, clockwise positive
+    int32_t elevation;          // Servo degrees
+};
+
+class AxisLink {
+private:
+    SnapshotRing<AxisSnapshot, AXIS_RING_SIZE> snapshots;
+    char line[AXIS_LINE_MAX];
+    uint8_t length = 0;
+    bool overflow = false;
+    uint32_t errors = 0;
+
+    /**
+     * @brief Parse one signed decimal field ending at `end`
+     */
+    static bool parseField(const char* text, char end, const char** next, int32_t& value) {
+        char* stop;
+        long parsed = strtol(text, &stop, 10);
+        if (stop == text || *stop != end) {
+            return false;
+        }
+        value = parsed;
+        *next = stop + 1;
+        return true;
+    }
+
+public:
+    /**
+     * @brief Parse one line without its newline
+     * @param text NUL-terminated line
+     * @param azimuth Receives the azimuth position
+     * @param elevation Receives the elevation position
+     * @return false if the line is not a valid AXIS report
+     */
+    static bool parse(const char* text, int32_t& azimuth, int32_t& elevation) {
+        if (strncmp(text, "AXIS:", 5) != 0) {
+            return false;
+        }
+        const char* next = text + 5;
+        return parseField(next, ',', &next, azimuth) && parseField(next, '\0', &next, elevation);
+    }
+
+    /**
+     * @brief Feed received bytes (UART receive context only)
+     * @param data Bytes from the UART
+     * @param len Number of bytes
+     * @param nowMs Current millis()
+     */
+    void feed(const uint8_t* data, size_t len, uint32_t nowMs) {
+        for (size_t i = 0; i < len; i++) {
+            char c = data[i];
+            if (c == '\r') {
+                continue;
+            }
+            if (c != '\n') {
+                if (length < AXIS_LINE_MAX - 1) {
+                    line[length++] = c;
+                } else {
+                    overflow = true;
+                }
+                continue;
+            }
+
+            line[length] = '\0';
+            AxisSnapshot snap;
+            if (!overflow && parse(line, snap.azimuth, snap.elevation)) {
+                snap.sequence = snapshots.published() + 1;
+                snap.timestampMs = nowMs;
+                snapshots.push(snap);
+            } else if (length > 0) {
+                errors++;
+            }
+            length = 0;
+            overflow = false;
+        }
+    }
+
+    /**
+     * @brief Copy the newest positions if they are recent
+     * @param out Destination
+     * @param nowMs Current millis()
+     * @return false if nothing was received within AXIS_STALE_MS
+     */
+    bool latest(AxisSnapshot& out, uint32_t nowMs) const {
+        return snapshots.latest(out) && nowMs - out.timestampMs <= AXIS_STALE_MS;
+    }
+
+    /**
+     * @brief Lines that were not valid AXIS reports
+     */
+    uint32_t parseErrors() const {
+        return errors;
+    }
+};
@@ -0,0 +1,96 @@
+/**
+ * @file CborWriter.h
+ * @brief Minimal CBOR (RFC 8949) encoder into a fixed buffer
+ * @author Yahya
+ *
+ * Plain C++ with no Arduino dependencies, so it also compiles in a
+ * native build.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Minimal CBOR encoder into a fixed buffer
+ *
+ * Only the types /api/state needs. Writing past the end sets a flag
+ * instead of failing each call; finish() then returns 0.
+ */
+class CborWriter {
+private:
+    uint8_t* out;
+    size_t capacity;
+    size_t pos = 0;
+    bool overflow = false;
+
+    void put(uint8_t byte) {
+        if (pos < capacity) {
+            out[pos++] = byte;
+        } else {
+            overflow = true;
+        }
+    }
+
+    void head(uint8_t major, uint32_t value) {
+        major <<= 5;
+        if (value < 24) {
+            put(major | value);
+        } else if (value <= 0xFF) {
+            put(major | 24);
+            put(value);
+        } else if (value <= 0xFFFF) {
+            put(major | 25);
+            put(value >> 8);
+            put(value);
+        } else {
+            put(major | 26);
+            put(value >> 24);
+            put(value >> 16);
+            put(value >> 8);
+            put(value);
+        }
+    }
+
+public:
+    CborWriter(uint8_t* buffer, size_t len) : out(buffer), capacity(len) {}
+
+    void map(uint32_t pairs) { head(5, pairs); }
+    void array(uint32_t items) { head(4, items); }
+    void null() { put(0xF6); }
+
+    void text(const char* s) {
+        size_t n = strlen(s);
+        head(3, n);
+        for (size_t i = 0; i < n; i++) {
+            put(s[i]);
+        }
+    }
+
+    void integer(int32_t value) {
+        if (value >= 0) {
+            head(0, value);
+        } else {
+            head(1, (uint32_t)(-1 - (int64_t)value));
+        }
+    }
+
+    void number(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        put(0xFA);
+        put(bits >> 24);
+        put(bits >> 16);
+        put(bits >> 8);
+        put(bits);
+    }
+
+    /**
+     * @return Encoded length, 0 if the buffer was too small
+     */
+    size_t finish() const {
+        return overflow ? 0 : pos;
+    }
+};
@@ -0,0 +1,183 @@
+/**
+ * @file ChunkedStream.h
+ * @brief Large responses streamed in fixed-size chunks from their source
+ * @author Yahya
+ *
+ * sendStream() wraps beginChunkedResponse around a source: any callable
+ *
+ *   size_t source(size_t offset, uint8_t* out, size_t len)
+ *
+ * that copies the bytes at `offset` into `out` and returns how many it
+ * wrote, 0 at the end. The source is asked for at most STREAM_CHUNK_SIZE
+ * bytes at a time, as the TCP window drains, and reads them straight from
+ * where they live (a ring buffer, a LittleFS file). The body is never
+ * assembled in memory, so a response costs its fixed-size source plus the
+ * library's send buffer, whatever the payload size.
+ *
+ * With -D ENABLE_STREAM_SELFTEST, StreamSelftest adds a generated payload
+ * of a few hundred KB that records the free heap while it is sent
+ * (scripts/stream_selftest.py drives it from a PC).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <FS.h>
+#include <esp_heap_caps.h>
+
+// Chunked Stream Configuration
+#define STREAM_CHUNK_SIZE       1024    // Most bytes asked of a source per call
+
+/**
+ * @brief Send a body produced by a source in fixed-size chunks
+ * @param request Request to answer
+ * @param contentType MIME type of the body
+ * @param source Callable size_t(size_t offset, uint8_t* out, size_t len);
+ *               copied into the response and destroyed with it
+ */
+template <typename Source>
+void sendStream(AsyncWebServerRequest* request, const char* contentType, Source source) {
+    AsyncWebServerResponse* response = request->beginChunkedResponse(
+        contentType,
+        [source](uint8_t* buffer, size_t maxLen, size_t index) mutable -> size_t {
+            return source(index, buffer, min(maxLen, (size_t)STREAM_CHUNK_SIZE));
+        });
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+}
+
+/**
+ * @brief Source reading a file sequentially; the file closes with the response
+ */
+struct FileSource {
+    File file;
+
+    size_t operator()(size_t, uint8_t* out, size_t len) {
+        return file ? file.read(out, len) : 0;
+    }
+};
+
+#ifdef ENABLE_STREAM_SELFTEST
+
+#include <LittleFS.h>
+
+// Stream Selftest Configuration
+#define STREAM_SELFTEST_KB      512     // Default payload
+#define STREAM_SELFTEST_MAX_KB  4096
+
+/**
+ * @brief Heap seen while one selftest stream was sent
+ */
+struct StreamRun {
+    uint32_t bytes;
+    uint32_t chunks;
+    uint32_t heapBefore;        // Free heap when the request arrived
+    uint32_t heapMin;           // Lowest free heap seen at any chunk
+    uint32_t largestMin;        // Smallest largest-free-block seen at any chunk
+};
+
+/**
+ * @brief Generated payload: consecutive little-endian 32-bit counters
+ */
+struct PatternSource {
+    size_t total;
+
+    size_t operator()(size_t offset, uint8_t* out, size_t len) {
+        size_t n = min(len, total - offset);
+        for (size_t i = 0; i < n; i++) {
+            size_t pos = offset + i;
+            out[i] = (uint32_t)(pos / 4) >> (8 * (pos % 4));
+        }
+        return n;
+    }
+};
+
+class StreamSelftest {
+private:
+    StreamRun last = {};
+    uint32_t runs = 0;
+    uint32_t lowestHeap = UINT32_MAX;
+
+    /**
+     * @brief Wraps a source and samples the heap at every chunk
+     */
+    template <typename Source>
+    struct Probe {
+        Source source;
+        StreamSelftest* owner;
+        StreamRun run;
+
+        size_t operator()(size_t offset, uint8_t* out, size_t len) {
+            size_t n = source(offset, out, len);
+            run.heapMin = min(run.heapMin, (uint32_t)heap_caps_get_free_size(MALLOC_CAP_8BIT));
+            run.largestMin = min(run.largestMin, (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+            if (n > 0) {
+                run.bytes += n;
+                run.chunks++;
+            } else {
+                owner->finished(run);
+            }
+            return n;
+        }
+    };
+
+    void finished(const StreamRun& run) {
+        last = run;
+        runs++;
+        lowestHeap = min(lowestHeap, run.heapMin);
+        Serial.printf("Stream selftest: %u bytes in %u chunks, free heap %u before, %u lowest\n",
+                      run.bytes, run.chunks, run.heapBefore, run.heapMin);
+    }
+
+    template <typename Source>
+    void start(AsyncWebServerRequest* request, const char* contentType, Source source) {
+        uint32_t heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        StreamRun run = {0, 0, heap, heap, (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT)};
+        sendStream(request, contentType, Probe<Source>{source, this, run});
+    }
+
+public:
+    /**
+     * @brief Register the selftest routes
+     *
+     * GET /selftest/stream?kb=N      N KB of counters (default STREAM_SELFTEST_KB)
+     * GET /selftest/stream?file=P    LittleFS file P through FileSource
+     * GET /selftest/stream/result    Heap figures of the last finished run (JSON)
+     */
+    void begin(AsyncWebServer& server) {
+        // Registered first: the /selftest/stream route also matches its sub-paths
+        server.on("/selftest/stream/result", HTTP_GET, [this](AsyncWebServerRequest* request) {
+            char json[192];
+            snprintf(json, sizeof(json),
+                     "{\"runs\":%u,\"bytes\":%u,\"chunks\":%u,\"heapBefore\":%u,\"heapMin\":%u,"
+                     "\"largestMin\":%u,\"lowestHeap\":%u,\"minFreeSinceBoot\":%u}",
+                     runs, last.bytes, last.chunks, last.heapBefore, last.heapMin, last.largestMin,
+                     runs ? lowestHeap : 0, (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+            request->send(200, "application/json", json);
+        });
+
+        server.on("/selftest/stream", HTTP_GET, [this](AsyncWebServerRequest* request) {
+            if (request->hasParam("file")) {
+                File file = LittleFS.open(request->getParam("file")->value(), "r");
+                if (!file || file.isDirectory()) {
+                    request->send(404, "text/plain", "no such file");
+                    return;
+                }
+                start(request, "application/octet-stream", FileSource{file});
+                return;
+            }
+
+            long kb = request->hasParam("kb") ? request->getParam("kb")->value().toInt() : STREAM_SELFTEST_KB;
+            if (kb < 1 || kb > STREAM_SELFTEST_MAX_KB) {
+                request->send(400, "text/plain", "kb must be 1-4096");
+                return;
+            }
+            start(request, "application/octet-stream", PatternSource{(size_t)kb * 1024});
+        });
+
+        Serial.println("Stream selftest enabled at /selftest/stream");
+    }
+};
+
+#endif
@@ -33,6 +33,17 @@ public:
         tft.setTextSize(1);
     }
 
+    /**
+     * @brief Turn the panel and backlight off before deep sleep
+     */
+    void sleep() {
+        tft.writecommand(TFT_DISPOFF);
+        tft.writecommand(TFT_SLPIN);
+#ifdef TFT_BL
+        digitalWrite(TFT_BL, !TFT_BACKLIGHT_ON);
+#endif
+    }
+
     /**
      * @brief Clear the entire display
      */
@@ -59,13 +70,14 @@ public:
      * @brief Display sensor data with label
      * @param label Sensor name/label
      * @param value Raw sensor value
-     * @param voltage Converted voltage value
+     * @param millivolts Calibrated voltage in millivolts
      * @param x X coordinate
      * @param y Y coordinate
      */
-    void showData(const char* label, int value, float voltage, int x, int y) {
-        String message = String(label) + ": " + String(value) + 
-                        " (" + String(voltage, 2) + " V)";
+    void showData(const char* label, int value, int millivolts, int x, int y) {
+        char message[48];
+        snprintf(message, sizeof(message), "%s: %d (%d.%02d V)",
+                 label, value, millivolts / 1000, (millivolts % 1000) / 10);
         tft.setCursor(x, y);
         tft.println(message);
     }
@@ -77,14 +89,16 @@ public:
      * @param x X coordinate
      * @param y Y coordinate
      */
-    void showDirection(const String& direction, int value, int x, int y) {
+    void showDirection(const char* direction, int value, int x, int y) {
         tft.setCursor(x, y);
         tft.setTextColor(TFT_YELLOW, TFT_BLACK);
-        tft.println("Sun: " + direction);
+        tft.print("Sun: ");
+        tft.println(direction);
         
         tft.setCursor(x, y + 10);
         tft.setTextColor(TFT_GREEN, TFT_BLACK);
-        tft.println("Int: " + String(value));
+        tft.print("Int: ");
+        tft.println(value);
         
         tft.setTextColor(TFT_WHITE, TFT_BLACK);
     }
@@ -11,64 +11,218 @@
 
 #include <Wire.h>
 #include <Arduino.h>
-#include <HTU21D.h>
 #include <ESPAsyncWebServer.h>
 #include <AsyncTCP.h>
+#include "SnapshotRing.h"
 
 // I2C Pin Configuration
 #define SDA_PIN 21
 #define SCL_PIN 22
 
+// HTU21D Configuration
+#define HTU21D_ADDRESS          0x40
+#define HTU21D_TRIGGER_TEMP     0xF3    // No-hold master: the sensor NACKs reads until done
+#define HTU21D_TRIGGER_HUMIDITY 0xF5
+#define HTU21D_SOFT_RESET       0xFE
+#define HTU21D_TEMP_CONV_MS     50      // Max conversion time, 14-bit temperature
+#define HTU21D_HUMIDITY_CONV_MS 16      // Max conversion time, 12-bit humidity
+#define HTU21D_RESET_MS         15
+#define HTU21D_RETRY_MS         5       // Poll interval if a result is late
+#define HTU21D_MAX_RETRIES      4
+#define ENV_RING_SIZE           8
+#define ENV_STALE_MS            5000    // Web handlers reject snapshots older than this
+
+/**
+ * @brief One completed temperature/humidity measurement
+ */
+struct HtuReading {
+    int16_t temperatureCenti;   // 0.01 degC
+    int16_t humidityCenti;      // 0.01 %RH
+    bool valid;
+};
+
 /**
- * @brief HTU21D Sensor wrapper class
+ * @brief Timestamped environment reading published by the sensor task
+ */
+struct EnvSnapshot {
+    uint32_t sequence;
+    uint32_t timestampMs;       // millis() when the cycle completed
+    int16_t temperatureCenti;   // 0.01 degC
+    int16_t humidityCenti;      // 0.01 %RH
+    bool valid;                 // false if the cycle failed
+};
+
+/**
+ * @brief Non-blocking HTU21D driver
+ *
+ * Measurements use the no-hold-master commands, so the bus is only busy
+ * for the actual transfers. A cycle is a small state machine driven by
+ * step(): trigger temperature, collect it and immediately trigger
+ * humidity in the same step, then collect humidity. step() returns how
+ * long the caller should sleep before the next step, so the owning task
+ * can wait on a timer instead of blocking inside Wire.
  */
 class HTU21D_Sensor {
 private:
-    HTU21D htu21d;
-    bool sensorFound;
+    enum State : uint8_t {
+        HTU_IDLE,
+        HTU_MEASURING_TEMP,
+        HTU_MEASURING_HUMIDITY
+    };
+
+    bool sensorFound = false;
+    State state = HTU_IDLE;
+    uint8_t retries = 0;
+    uint16_t temperatureRaw = 0;
+    HtuReading last = {0, 0, false};
+    uint32_t errors = 0;
 
-public:
     /**
-     * @brief Constructor - Initialize I2C and HTU21D sensor
+     * @brief CRC-8 over the two data bytes (polynomial x^8 + x^5 + x^4 + 1)
      */
-    HTU21D_Sensor() {
-        Wire.begin(SDA_PIN, SCL_PIN);
-        
-        if (!htu21d.begin()) {
-            Serial.println("ERROR: HTU21D sensor not detected!");
-            sensorFound = false;
-        } else {
-            Serial.println("HTU21D sensor initialized successfully");
-            sensorFound = true;
+    static uint8_t crc8(uint8_t msb, uint8_t lsb) {
+        uint16_t data = (msb << 8) | lsb;
+        uint32_t remainder = (uint32_t)data << 8;
+        uint32_t divisor = 0x988000;    // 0x131 shifted to bit 23
+
+        for (int i = 0; i < 16; i++) {
+            if (remainder & (1UL << (23 - i))) {
+                remainder ^= divisor;
+            }
+            divisor >>= 1;
         }
+        return (uint8_t)remainder;
+    }
+
+    bool command(uint8_t cmd) {
+        Wire.beginTransmission(HTU21D_ADDRESS);
+        Wire.write(cmd);
+        return Wire.endTransmission() == 0;
     }
 
     /**
-     * @brief Read temperature from sensor
-     * @return Temperature in Celsius, NAN if error
+     * @brief Read a finished measurement
+     * @param raw Receives the 16-bit value with status bits cleared
+     * @return 1 on success, 0 if the sensor is still converting, -1 on error
      */
-    float readTemperature() {
-        if (sensorFound) {
-            float temp = htu21d.getTemperature();
-            return temp;
-        } else {
-            Serial.println("ERROR: HTU21D sensor not available");
-            return NAN;
+    int collect(uint16_t& raw) {
+        if (Wire.requestFrom((uint8_t)HTU21D_ADDRESS, (uint8_t)3) != 3) {
+            return 0;   // NACK: conversion not finished
         }
+
+        uint8_t msb = Wire.read();
+        uint8_t lsb = Wire.read();
+        uint8_t crc = Wire.read();
+        if (crc8(msb, lsb) != crc) {
+            return -1;
+        }
+
+        raw = ((msb << 8) | lsb) & 0xFFFC;
+        return 1;
+    }
+
+    /**
+     * @brief Abort the current cycle
+     * @return 0 (cycle finished)
+     */
+    uint32_t fail() {
+        errors++;
+        last.valid = false;
+        state = HTU_IDLE;
+        return 0;
     }
 
     /**
-     * @brief Read humidity from sensor
-     * @return Humidity as percentage, NAN if error
+     * @brief Collect the pending result or schedule a retry
+     * @param raw Receives the value
+     * @return 1 when collected, 0 if a retry was scheduled, -1 on failure
      */
-    float readHumidity() {
+    int collectOrRetry(uint16_t& raw) {
+        int result = collect(raw);
+        if (result == 0 && ++retries <= HTU21D_MAX_RETRIES) {
+            return 0;
+        }
+        retries = 0;
+        return result > 0 ? 1 : -1;
+    }
+
+public:
+    /**
+     * @brief Soft-reset the sensor and check it responds
+     * Wire must already be started.
+     * @return true if the sensor acknowledged
+     */
+    bool begin() {
+        sensorFound = command(HTU21D_SOFT_RESET);
         if (sensorFound) {
-            float humidity = htu21d.getHumidity();
-            return humidity;
+            delay(HTU21D_RESET_MS);
+            Serial.println("HTU21D sensor initialized successfully");
         } else {
-            Serial.println("ERROR: HTU21D sensor not available");
-            return NAN;
+            Serial.println("ERROR: HTU21D sensor not detected!");
         }
+        return sensorFound;
+    }
+
+    /**
+     * @brief Advance the measurement cycle
+     * @return Milliseconds to wait before calling again, 0 when the cycle
+     *         is complete (see lastReading())
+     */
+    uint32_t step() {
+        uint16_t raw;
+
+        if (!sensorFound) {
+            return fail();
+        }
+
+        switch (state) {
+        case HTU_IDLE:
+            if (!command(HTU21D_TRIGGER_TEMP)) {
+                return fail();
+            }
+            state = HTU_MEASURING_TEMP;
+            return HTU21D_TEMP_CONV_MS;
+
+        case HTU_MEASURING_TEMP:
+            switch (collectOrRetry(raw)) {
+            case 0:
+                return HTU21D_RETRY_MS;
+            case -1:
+                return fail();
+            }
+            temperatureRaw = raw;
+
+            // Start humidity right away; its conversion overlaps our wait
+            if (!command(HTU21D_TRIGGER_HUMIDITY)) {
+                return fail();
+            }
+            state = HTU_MEASURING_HUMIDITY;
+            return HTU21D_HUMIDITY_CONV_MS;
+
+        case HTU_MEASURING_HUMIDITY:
+            switch (collectOrRetry(raw)) {
+            case 0:
+                return HTU21D_RETRY_MS;
+            case -1:
+                return fail();
+            }
+
+            // T = -46.85 + 175.72 * raw / 2^16, RH = -6 + 125 * raw / 2^16;
+            // RH spans -6..119 %, the datasheet clamps it to 0..100 %
+            last.temperatureCenti = (int16_t)(((17572UL * temperatureRaw) >> 16) - 4685);
+            last.humidityCenti = (int16_t)constrain((int32_t)((12500UL * raw) >> 16) - 600, 0, 10000);
+            last.valid = true;
+            state = HTU_IDLE;
+            return 0;
+        }
+        return fail();
+    }
+
+    /**
+     * @brief Result of the most recently completed cycle
+     */
+    const HtuReading& lastReading() const {
+        return last;
     }
 
     /**
@@ -80,50 +234,76 @@ public:
     }
 
     /**
-     * @brief Get both temperature and humidity in one call
-     * @param temp Reference to store temperature value
-     * @param humid Reference to store humidity value
-     * @return true if successful, false otherwise
+     * @brief Failed cycles since boot
      */
-    bool readBoth(float& temp, float& humid) {
-        if (!sensorFound) {
-            return false;
-        }
-        
-        temp = readTemperature();
-        humid = readHumidity();
-        
-        return (!isnan(temp) && !isnan(humid));
+    uint32_t errorCount() const {
+        return errors;
     }
 };
 
-// Global sensor instance
+// Global sensor instance, owned by readSensorsTask
 HTU21D_Sensor sensor;
 
+// Latest readings; written only by readSensorsTask, read lock-free by anyone
+SnapshotRing<EnvSnapshot, ENV_RING_SIZE> envSnapshots;
+
 /**
- * @brief Web handler for temperature endpoint
+ * @brief Format a fixed-point value with two decimals
+ * @return Characters written (snprintf semantics)
  */
-void handleTemperature(AsyncWebServerRequest *request) {
-    float temp = sensor.readTemperature();
-    
-    if (isnan(temp)) {
+static inline int formatCenti(char* buf, size_t len, int centi) {
+    return snprintf(buf, len, "%s%d.%02d", centi < 0 ? "-" : "", abs(centi) / 100, abs(centi) % 100);
+}
+
+/**
+ * @brief Publish the result of a completed cycle (sensor task only)
+ * @param reading Reading from the driver
+ */
+void publishEnvSnapshot(const HtuReading& reading) {
+    EnvSnapshot snap;
+
+    snap.sequence = envSnapshots.published() + 1;
+    snap.timestampMs = millis();
+    snap.temperatureCenti = reading.temperatureCenti;
+    snap.humidityCenti = reading.humidityCenti;
+    snap.valid = reading.valid;
+    envSnapshots.push(snap);
+}
+
+/**
+ * @brief Send one field of the latest snapshot as plain text
+ * @param request Web request
+ * @param humidity true for humidity, false for temperature
+ */
+void sendEnvValue(AsyncWebServerRequest *request, bool humidity) {
+    EnvSnapshot snap;
+
+    if (!envSnapshots.latest(snap) || millis() - snap.timestampMs > ENV_STALE_MS) {
+        request->send(503, "text/plain", "No recent reading");
+        return;
+    }
+    if (!snap.valid) {
         request->send(500, "text/plain", "Sensor Error");
-    } else {
-        request->send(200, "text/plain", String(temp, 2));
+        return;
     }
+
+    char text[12];
+    formatCenti(text, sizeof(text), humidity ? snap.humidityCenti : snap.temperatureCenti);
+    request->send(200, "text/plain", text);
+}
+
+/**
+ * @brief Web handler for temperature endpoint
+ */
+void handleTemperature(AsyncWebServerRequest *request) {
+    sendEnvValue(request, false);
 }
 
 /**
  * @brief Web handler for humidity endpoint
  */
 void handleHumidity(AsyncWebServerRequest *request) {
-    float humidity = sensor.readHumidity();
-    
-    if (isnan(humidity)) {
-        request->send(500, "text/plain", "Sensor Error");
-    } else {
-        request->send(200, "text/plain", String(humidity, 2));
-    }
+    sendEnvValue(request, true);
 }
 
 /**
@@ -0,0 +1,358 @@
+/**
+ * @file HistoryStore.h
+ * @brief Fixed-memory time-series history with tiered downsampling
+ * @author Yahya
+ *
+ * Keeps temperature, humidity and total irradiance in three rings:
+ * raw 1 s samples for the last hour, per-minute min/avg/max for a day
+ * and per-10-minute min/avg/max for a week. Values are packed int16
+ * (0.01 units, raw ADC sum for irradiance). All storage is allocated
+ * once in begin(); recording and serving never touch the heap.
+ *
+ * The store is exported as one little-endian binary stream, read in
+ * arbitrary slices so it can be served as a chunked HTTP response:
+ *
+ *   header   "HIST", version, field count, reserved, nowSec (uint32)
+ *   3 tiers  count (uint16), periodSec (uint16), newestSec (uint32)
+ *   tier 0   count records of fields x int16, oldest first
+ *   tier 1/2 count records of fields x (min, avg, max) int16, oldest first
+ *
+ * Times are seconds of uptime; a client anchors them with nowSec.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+// History Configuration
+#define HISTORY_FIELDS          3       // Temperature, humidity, irradiance
+#define HISTORY_RAW_LEN         3600    // 1 h of 1 s samples
+#define HISTORY_MINUTE_LEN      1440    // 1 day of 1 min rollups
+#define HISTORY_TENMIN_LEN      1008    // 1 week of 10 min rollups
+#define HISTORY_MINUTE_SEC      60
+#define HISTORY_TENMIN_SEC      600
+#define HISTORY_INVALID         INT16_MIN
+#define HISTORY_VERSION         1
+#define HISTORY_HEADER_SIZE     36
+#define HISTORY_MAX_GAP         60      // Longer gaps are padded a tier at a time
+
+enum HistoryField {
+    HISTORY_TEMPERATURE = 0,
+    HISTORY_HUMIDITY,
+    HISTORY_IRRADIANCE
+};
+
+class HistoryStore {
+private:
+    /**
+     * @brief One ring of fixed-size int16 records
+     */
+    struct Tier {
+        int16_t* data = nullptr;
+        uint16_t capacity = 0;
+        uint16_t words = 0;         // int16 per record
+        uint16_t periodSec = 0;
+        uint32_t written = 0;       // Records ever pushed; slot = index % capacity
+        uint32_t newestSec = 0;
+
+        void push(const int16_t* record, uint32_t sec) {
+            memcpy(&data[(written % capacity) * words], record, words * sizeof(int16_t));
+            written++;
+            newestSec = sec;
+        }
+
+        uint16_t size() const {
+            return written < capacity ? written : capacity;
+        }
+    };
+
+    /**
+     * @brief Running min/sum/max of one rollup period
+     */
+    struct Accumulator {
+        int16_t min[HISTORY_FIELDS];
+        int16_t max[HISTORY_FIELDS];
+        int32_t sum[HISTORY_FIELDS];
+        uint16_t count[HISTORY_FIELDS];
+
+        void reset() {
+            for (int f = 0; f < HISTORY_FIELDS; f++) {
+                min[f] = INT16_MAX;
+                max[f] = INT16_MIN;
+                sum[f] = 0;
+                count[f] = 0;
+            }
+        }
+
+        void add(int f, int16_t lo, int16_t avg, int16_t hi, uint16_t weight) {
+            if (avg == HISTORY_INVALID || weight == 0) {
+                return;
+            }
+            if (lo < min[f]) min[f] = lo;
+            if (hi > max[f]) max[f] = hi;
+            sum[f] += (int32_t)avg * weight;
+            count[f] += weight;
+        }
+
+        void finish(int16_t* record) const {
+            for (int f = 0; f < HISTORY_FIELDS; f++) {
+                bool any = count[f] > 0;
+                record[f * 3] = any ? min[f] : HISTORY_INVALID;
+                record[f * 3 + 1] = any ? (int16_t)(sum[f] / count[f]) : HISTORY_INVALID;
+                record[f * 3 + 2] = any ? max[f] : HISTORY_INVALID;
+            }
+        }
+    };
+
+    Tier tiers[3];
+    Accumulator minuteAcc;
+    Accumulator tenMinAcc;
+    uint32_t lastSec = 0;
+    bool started = false;
+    mutable portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+    void pushRaw(const int16_t* values, uint32_t sec) {
+        tiers[0].push(values, sec);
+        for (int f = 0; f < HISTORY_FIELDS; f++) {
+            minuteAcc.add(f, values[f], values[f], values[f], 1);
+        }
+    }
+
+    /**
+     * @brief Close the minute ending at endSec and roll it into the 10 min tier
+     */
+    void closeMinute(uint32_t endSec) {
+        int16_t record[HISTORY_FIELDS * 3];
+        minuteAcc.finish(record);
+        tiers[1].push(record, endSec);
+
+        // Minute averages are weighted by their sample count in the 10 min rollup
+        for (int f = 0; f < HISTORY_FIELDS; f++) {
+            tenMinAcc.add(f, record[f * 3], record[f * 3 + 1], record[f * 3 + 2], minuteAcc.count[f]);
+        }
+        minuteAcc.reset();
+
+        if ((endSec + 1) % HISTORY_TENMIN_SEC == 0) {
+            tenMinAcc.finish(record);
+            tenMinAcc.reset();
+            tiers[2].push(record, endSec);
+        }
+    }
+
+    /**
+     * @brief Push count invalid records ending at newestSec, at most a full ring
+     */
+    static void pad(Tier& tier, uint32_t count, uint32_t newestSec) {
+        int16_t record[HISTORY_FIELDS * 3];
+        for (int w = 0; w < tier.words; w++) {
+            record[w] = HISTORY_INVALID;
+        }
+        for (uint32_t i = min(count, (uint32_t)tier.capacity); i > 0; i--) {
+            tier.push(record, newestSec);
+        }
+    }
+
+    /**
+     * @brief Advance every tier to endSec over a long stall
+     *
+     * Same result as recording invalid samples for each missing second,
+     * but each tier gets at most one ring of padding: the open minute and
+     * 10 min rollups close at their own boundaries, the periods after them
+     * are invalid.
+     */
+    void skip(uint32_t endSec) {
+        uint32_t minutes = endSec / HISTORY_MINUTE_SEC - lastSec / HISTORY_MINUTE_SEC;
+        uint32_t tens = endSec / HISTORY_TENMIN_SEC - lastSec / HISTORY_TENMIN_SEC;
+
+        pad(tiers[0], endSec - lastSec, endSec);
+
+        if (minutes > 0) {
+            uint32_t minuteEnd = (lastSec / HISTORY_MINUTE_SEC + 1) * HISTORY_MINUTE_SEC - 1;
+            closeMinute(minuteEnd);
+            if (tens > 0 && (minuteEnd + 1) % HISTORY_TENMIN_SEC != 0) {
+                int16_t record[HISTORY_FIELDS * 3];
+                tenMinAcc.finish(record);
+                tenMinAcc.reset();
+                tiers[2].push(record, (lastSec / HISTORY_TENMIN_SEC + 1) * HISTORY_TENMIN_SEC - 1);
+            }
+            pad(tiers[1], minutes - 1, endSec / HISTORY_MINUTE_SEC * HISTORY_MINUTE_SEC - 1);
+            if (tens > 0) {
+                pad(tiers[2], tens - 1, endSec / HISTORY_TENMIN_SEC * HISTORY_TENMIN_SEC - 1);
+            }
+        }
+        lastSec = endSec;
+    }
+
+public:
+    /**
+     * @brief Allocate all rings (once, at boot)
+     * @return false if memory could not be allocated
+     */
+    bool begin() {
+        const uint16_t capacity[3] = {HISTORY_RAW_LEN, HISTORY_MINUTE_LEN, HISTORY_TENMIN_LEN};
+        const uint16_t words[3] = {HISTORY_FIELDS, HISTORY_FIELDS * 3, HISTORY_FIELDS * 3};
+        const uint16_t period[3] = {1, HISTORY_MINUTE_SEC, HISTORY_TENMIN_SEC};
+        size_t total = 0;
+
+        for (int t = 0; t < 3; t++) {
+            size_t bytes = (size_t)capacity[t] * words[t] * sizeof(int16_t);
+            tiers[t].data = (int16_t*)heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+            if (!tiers[t].data) {
+                Serial.println("ERROR: History allocation failed");
+                return false;
+            }
+            tiers[t].capacity = capacity[t];
+            tiers[t].words = words[t];
+            tiers[t].periodSec = period[t];
+            total += bytes;
+        }
+        minuteAcc.reset();
+        tenMinAcc.reset();
+
+        Serial.printf("History store: %u bytes\n", total);
+        return true;
+    }
+
+    /**
+     * @brief Record one sample (single writer, about once per second)
+     *
+     * Gaps are filled with invalid samples so every tier keeps a fixed
+     * period and a client can derive each record's time from newestSec;
+     * rollups close on minute boundaries of uptime. Gaps longer than
+     * HISTORY_MAX_GAP s are padded a tier at a time instead of per second.
+     *
+     * @param values HISTORY_FIELDS values, HISTORY_INVALID if unknown
+     * @param sec Uptime in seconds
+     */
+    void record(const int16_t values[HISTORY_FIELDS], uint32_t sec) {
+        if (!tiers[0].data || (started && sec <= lastSec)) {
+            return;
+        }
+
+        const int16_t gap[HISTORY_FIELDS] = {HISTORY_INVALID, HISTORY_INVALID, HISTORY_INVALID};
+        uint32_t stall = started ? sec - lastSec - 1 : 0;
+
+        portENTER_CRITICAL(&lock);
+        if (stall >= HISTORY_MAX_GAP) {
+            skip(sec - 1);
+        }
+
+        for (uint32_t s = started ? lastSec + 1 : sec; s <= sec; s++) {
+            if (started && s % HISTORY_MINUTE_SEC == 0) {
+                closeMinute(s - 1);
+            }
+            pushRaw(s == sec ? values : gap, s);
+            started = true;
+        }
+        lastSec = sec;
+        portEXIT_CRITICAL(&lock);
+
+        if (stall >= HISTORY_MAX_GAP) {
+            Serial.printf("History: %u s without samples, marked invalid\n", (unsigned)stall);
+        }
+    }
+
+    /**
+     * @brief Consistent sizes of all tiers at one instant
+     */
+    struct View {
+        uint32_t nowSec;
+        uint16_t size[3];
+        uint32_t first[3];          // Absolute index of the oldest record
+        uint32_t newestSec[3];
+    };
+
+    /**
+     * @brief Capture the tier sizes for one export
+     */
+    View view() const {
+        View v;
+        portENTER_CRITICAL(&lock);
+        v.nowSec = millis() / 1000;
+        for (int t = 0; t < 3; t++) {
+            v.size[t] = tiers[t].size();
+            v.first[t] = tiers[t].written - v.size[t];
+            v.newestSec[t] = tiers[t].newestSec;
+        }
+        portEXIT_CRITICAL(&lock);
+        return v;
+    }
+
+    /**
+     * @brief Total length of the export for a view
+     */
+    size_t exportSize(const View& v) const {
+        size_t total = HISTORY_HEADER_SIZE;
+        for (int t = 0; t < 3; t++) {
+            total += (size_t)v.size[t] * tiers[t].words * sizeof(int16_t);
+        }
+        return total;
+    }
+
+    /**
+     * @brief Copy a slice of the export stream
+     *
+     * Records are addressed by absolute index, so samples recorded while a
+     * transfer is running do not shift it. A record that was overwritten
+     * before it was sent is exported as invalid; a record is never torn.
+     *
+     * @param v View from view()
+     * @param offset Byte offset into the stream
+     * @param out Destination
+     * @param len Maximum bytes to copy
+     * @return Bytes copied, 0 at the end
+     */
+    size_t exportSlice(const View& v, size_t offset, uint8_t* out, size_t len) const {
+        size_t written = 0;
+
+        if (offset < HISTORY_HEADER_SIZE) {
+            uint8_t header[HISTORY_HEADER_SIZE] = {'H', 'I', 'S', 'T', HISTORY_VERSION, HISTORY_FIELDS, 0, 0};
+            memcpy(&header[8], &v.nowSec, 4);
+            for (int t = 0; t < 3; t++) {
+                memcpy(&header[12 + t * 8], &v.size[t], 2);
+                memcpy(&header[14 + t * 8], &tiers[t].periodSec, 2);
+                memcpy(&header[16 + t * 8], &v.newestSec[t], 4);
+            }
+
+            size_t n = min(len, (size_t)HISTORY_HEADER_SIZE - offset);
+            memcpy(out, &header[offset], n);
+            written += n;
+        }
+
+        size_t base = HISTORY_HEADER_SIZE;
+        for (int t = 0; t < 3 && written < len; t++) {
+            const size_t recordBytes = tiers[t].words * sizeof(int16_t);
+            const size_t tierBytes = (size_t)v.size[t] * recordBytes;
+            size_t pos = offset + written;
+
+            if (pos < base + tierBytes) {
+                size_t rel = pos - base;
+                while (rel < tierBytes && written < len) {
+                    uint16_t index = rel / recordBytes;
+                    size_t within = rel % recordBytes;
+                    int16_t record[HISTORY_FIELDS * 3];
+
+                    uint32_t absolute = v.first[t] + index;
+                    portENTER_CRITICAL(&lock);
+                    if (tiers[t].written - absolute <= tiers[t].capacity) {
+                        memcpy(record, &tiers[t].data[(absolute % tiers[t].capacity) * tiers[t].words],
+                               recordBytes);
+                    } else {
+                        for (int w = 0; w < tiers[t].words; w++) {
+                            record[w] = HISTORY_INVALID;
+                        }
+                    }
+                    portEXIT_CRITICAL(&lock);
+
+                    size_t n = min(len - written, recordBytes - within);
+                    memcpy(out + written, (uint8_t*)record + within, n);
+                    written += n;
+                    rel += n;
+                }
+            }
+            base += tierBytes;
+        }
+        return written;
+    }
+};
@@ -0,0 +1,114 @@
+/**
+ * @file LightCalibrationStore.h
+ * @brief Dark/uniform-light calibration routine and NVS persistence
+ * @author Yahya
+ *
+ * Calibration runs in two steps: capture with all four sensors covered,
+ * then capture under uniform light (e.g. a diffuser over the sensor head).
+ * The resulting gain/offset set is stored as a single NVS blob, so startup
+ * loads it with one read.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "Lys.h"
+#include "LightSampler.h"
+
+// Calibration Store Configuration
+#define LIGHT_CAL_NAMESPACE "lightcal"
+#define LIGHT_CAL_KEY       "v1"
+#define LIGHT_CAL_MAGIC     0x4C43      // "LC"
+
+class LightCalibrationStore {
+private:
+    struct Record {
+        uint16_t magic;
+        uint16_t size;
+        LightCalibration calibration;
+    };
+
+    uint16_t dark[LIGHT_CHANNELS] = {};
+    bool haveDark = false;
+
+public:
+    /**
+     * @brief Load the stored calibration
+     * @param out Receives the stored calibration, or identity if none
+     * @return true if a valid record was found
+     */
+    bool load(LightCalibration& out) {
+        Preferences prefs;
+        Record record;
+
+        out = LightCalibration();
+        if (!prefs.begin(LIGHT_CAL_NAMESPACE, true)) {
+            return false;
+        }
+        size_t len = prefs.getBytes(LIGHT_CAL_KEY, &record, sizeof(record));
+        prefs.end();
+
+        if (len != sizeof(record) || record.magic != LIGHT_CAL_MAGIC ||
+            record.size != sizeof(LightCalibration)) {
+            Serial.println("Light calibration: none stored, using identity");
+            return false;
+        }
+
+        out = record.calibration;
+        Serial.println("Light calibration loaded");
+        return true;
+    }
+
+    /**
+     * @brief Persist a calibration
+     * @param cal Calibration to store
+     * @return true on success
+     */
+    bool save(const LightCalibration& cal) {
+        Preferences prefs;
+        Record record = {LIGHT_CAL_MAGIC, sizeof(LightCalibration), cal};
+
+        if (!prefs.begin(LIGHT_CAL_NAMESPACE, false)) {
+            return false;
+        }
+        bool ok = prefs.putBytes(LIGHT_CAL_KEY, &record, sizeof(record)) == sizeof(record);
+        prefs.end();
+        return ok;
+    }
+
+    /**
+     * @brief Step 1: record the dark reference (sensors covered)
+     * @param snapshot Current light snapshot
+     */
+    void captureDark(const LightSnapshot& snapshot) {
+        memcpy(dark, snapshot.uncorrected, sizeof(dark));
+        haveDark = true;
+    }
+
+    /**
+     * @brief Step 2: record the uniform-light reference, compute and store
+     * @param snapshot Current light snapshot
+     * @param out Receives the new calibration on success
+     * @param stored Set to whether the new calibration was written to NVS
+     * @return false without a dark capture or if any channel span is too small
+     */
+    bool captureUniform(const LightSnapshot& snapshot, LightCalibration& out, bool& stored) {
+        stored = false;
+        if (!haveDark || !out.compute(dark, snapshot.uncorrected)) {
+            return false;
+        }
+
+        haveDark = false;
+        stored = save(out);
+        if (!stored) {
+            Serial.println("ERROR: Failed to store light calibration");
+        }
+
+        for (int i = 0; i < LIGHT_CHANNELS; i++) {
+            Serial.printf("Light calibration ch%d: offset %u, gain %u/4096\n",
+                          i, out.offset[i], out.gain[i]);
+        }
+        return true;
+    }
+};
@@ -0,0 +1,258 @@
+/**
+ * @file LightSampler.h
+ * @brief Continuous DMA sampling of the four light sensor channels
+ * @author Yahya
+ *
+ * Runs ADC1 in continuous mode through the I2S DMA engine, scanning the
+ * four light channels at a fixed aggregate rate. A small task runs every
+ * sample through the per-channel LightFilter chain (see Lys.h) and publishes
+ * one coherent four-channel snapshot per decision window (20-100 Hz) into a
+ * SnapshotRing. Consumers (UART sender, display, web) read the ring at their
+ * own pace; none of them can hold up the sampler.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include <driver/i2s.h>
+#include <driver/adc.h>
+#include "Lys.h"
+#include "SnapshotRing.h"
+#include "TrackingConfig.h"
+
+// Sampler Configuration
+#define LIGHT_SAMPLE_RATE    10000  // Aggregate samples/s over all four channels
+#define LIGHT_DMA_BUF_COUNT  4
+#define LIGHT_DMA_BUF_LEN    64     // Samples per DMA buffer (6.4 ms at 10 kS/s)
+#define LIGHT_SAMPLER_STACK  3072
+#define LIGHT_SAMPLER_PRIO   2
+#define LIGHT_SAMPLER_CORE   1
+#define LIGHT_I2S_PORT       I2S_NUM_0  // Only I2S0 can be driven by the built-in ADC
+#define LIGHT_SENSE_RATE_HZ  50     // Snapshots per second
+#define LIGHT_SENSE_RATE_MIN 20
+#define LIGHT_SENSE_RATE_MAX 100
+#define LIGHT_RING_SIZE      64     // Snapshots kept for slow consumers (power of two)
+#define LIGHT_IDLE_SAMPLE_RATE 2000 // Aggregate samples/s while the sky is not trackable
+#define LIGHT_IDLE_RATE_HZ   2      // Snapshots per second while the sky is not trackable
+
+/**
+ * @brief Four-channel light reading for one decision window
+ */
+struct LightSnapshot {
+    uint32_t sequence;                  // Increments once per window
+    uint32_t timestampMs;               // millis() when the window closed
+    uint16_t level[LIGHT_CHANNELS];     // Calibrated value per channel, 12-bit ADC scale
+    uint16_t filtered[LIGHT_CHANNELS];  // Calibrated value per channel, Q4 (LIGHT_FRAC_BITS)
+    uint16_t uncorrected[LIGHT_CHANNELS];   // Filtered Q4 before gain/offset (for calibrating)
+    uint16_t samples;                   // Raw samples taken per channel in this window
+    uint8_t sky;                        // SkyCondition at the end of this window
+};
+
+class LightSampler {
+private:
+    // ADC1 channel -> LightChannel, -1 for channels that are not scanned
+    static constexpr int8_t channelMap[8] = {
+        LIGHT_DOWN, -1, -1, LIGHT_UP, LIGHT_LEFT, LIGHT_RIGHT, -1, -1
+    };
+
+    uint32_t samplesPerWindow;          // Aggregate DMA samples per snapshot
+    uint32_t activeRateHz;
+    uint32_t activeSampleRate;
+    SkyClassifier sky;                  // Owned by the sampler task
+    TrackingConfigReader config;        // Owned by the sampler task
+    TaskHandle_t task = nullptr;
+    LightFilter filters[LIGHT_CHANNELS];    // Owned by the sampler task after begin()
+
+    // Double-buffered gain/offset; activeCalibration selects the slot in use
+    LightCalibration calibration[2];
+    std::atomic<uint8_t> activeCalibration{0};
+
+    SnapshotRing<LightSnapshot, LIGHT_RING_SIZE> ring;
+
+    /**
+     * @brief Publish a finished window (sampler task only)
+     */
+    void publish(const uint16_t count[LIGHT_CHANNELS]) {
+        LightSnapshot slot;
+
+        slot.sequence = ring.published() + 1;
+        slot.timestampMs = millis();
+        slot.samples = UINT16_MAX;
+        const LightCalibration& cal = calibration[activeCalibration.load(std::memory_order_acquire)];
+        for (int i = 0; i < LIGHT_CHANNELS; i++) {
+            uint16_t q4 = cal.apply(i, filters[i].valueQ4());
+            slot.uncorrected[i] = filters[i].valueQ4();
+            slot.filtered[i] = q4;
+            slot.level[i] = (q4 + (1 << (LIGHT_FRAC_BITS - 1))) >> LIGHT_FRAC_BITS;
+            slot.samples = min(slot.samples, count[i]);
+        }
+
+        sky.setOvercastThreshold(config.get().minIrradiance);
+        if (sky.update(computeSunError(slot.level), slot.timestampMs)) {
+            Serial.printf("Sky condition: %s\n", skyConditionName(sky.condition()));
+            applyRate(sky.tracking());
+        }
+        slot.sky = sky.condition();
+
+        ring.push(slot);
+    }
+
+    /**
+     * @brief Switch between the tracking rate and the slow idle rate
+     * Runs on the sampler task, which owns the filters and window length.
+     * @param active true for full-rate tracking
+     */
+    void applyRate(bool active) {
+        uint32_t sampleRate = active ? activeSampleRate : LIGHT_IDLE_SAMPLE_RATE;
+        uint32_t rateHz = active ? activeRateHz : LIGHT_IDLE_RATE_HZ;
+
+        i2s_set_sample_rates(LIGHT_I2S_PORT, sampleRate);
+        samplesPerWindow = sampleRate / rateHz;
+        for (int i = 0; i < LIGHT_CHANNELS; i++) {
+            filters[i].configure(sampleRate / LIGHT_CHANNELS);
+        }
+    }
+
+    /**
+     * @brief Sampler task: drain DMA blocks and close a window every samplesPerWindow
+     */
+    static void samplerTask(void* arg) {
+        LightSampler* self = static_cast<LightSampler*>(arg);
+        uint16_t dma[LIGHT_DMA_BUF_LEN];
+        uint16_t count[LIGHT_CHANNELS] = {};
+        uint32_t inWindow = 0;
+
+        for (;;) {
+            size_t bytesRead = 0;
+            i2s_read(LIGHT_I2S_PORT, dma, sizeof(dma), &bytesRead, portMAX_DELAY);
+
+            // Each word carries the ADC1 channel in bits 15..12 and the value in 11..0
+            for (size_t i = 0; i < bytesRead / sizeof(uint16_t); i++) {
+                int8_t ch = channelMap[(dma[i] >> 12) & 0x7];
+                if (ch >= 0) {
+                    self->filters[ch].push(dma[i] & 0x0FFF);
+                    if (count[ch] < UINT16_MAX) {
+                        count[ch]++;
+                    }
+                }
+
+                // Windows are counted in samples so the rate follows the ADC clock exactly
+                if (++inWindow >= self->samplesPerWindow) {
+                    self->publish(count);
+                    memset(count, 0, sizeof(count));
+                    inWindow = 0;
+                }
+            }
+        }
+    }
+
+public:
+    /**
+     * @brief Configure ADC1 scan + I2S DMA and start the sampler task
+     * @param rateHz Snapshots per second, clamped to LIGHT_SENSE_RATE_MIN..MAX
+     * @param sampleRate Aggregate sample rate over all four channels
+     * @return true on success
+     */
+    bool begin(uint32_t rateHz = LIGHT_SENSE_RATE_HZ, uint32_t sampleRate = LIGHT_SAMPLE_RATE) {
+        rateHz = constrain(rateHz, LIGHT_SENSE_RATE_MIN, LIGHT_SENSE_RATE_MAX);
+        activeRateHz = rateHz;
+        activeSampleRate = sampleRate;
+        samplesPerWindow = sampleRate / rateHz;
+
+        for (int i = 0; i < LIGHT_CHANNELS; i++) {
+            filters[i].configure(sampleRate / LIGHT_CHANNELS);
+        }
+
+        i2s_config_t i2sConfig = {};
+        i2sConfig.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN);
+        i2sConfig.sample_rate = sampleRate;
+        i2sConfig.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+        i2sConfig.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;
+        i2sConfig.communication_format = I2S_COMM_FORMAT_STAND_MSB;
+        i2sConfig.dma_buf_count = LIGHT_DMA_BUF_COUNT;
+        i2sConfig.dma_buf_len = LIGHT_DMA_BUF_LEN;
+
+        if (i2s_driver_install(LIGHT_I2S_PORT, &i2sConfig, 0, NULL) != ESP_OK) {
+            Serial.println("ERROR: I2S driver install failed");
+            return false;
+        }
+        i2s_set_adc_mode(ADC_UNIT_1, ADC1_CHANNEL_0);
+
+        // Scan pattern: one conversion of each light channel per round
+        static adc_digi_pattern_table_t pattern[LIGHT_CHANNELS];
+        const adc1_channel_t channels[LIGHT_CHANNELS] = {
+            ADC1_CHANNEL_4,  // GPIO32, Left
+            ADC1_CHANNEL_5,  // GPIO33, Right
+            ADC1_CHANNEL_3,  // GPIO39, Up
+            ADC1_CHANNEL_0,  // GPIO36, Down
+        };
+        for (int i = 0; i < LIGHT_CHANNELS; i++) {
+            pattern[i].atten = ADC_ATTENUATION;
+            pattern[i].bit_width = ADC_RESOLUTION;
+            pattern[i].channel = channels[i];
+        }
+
+        adc_digi_config_t digiConfig = {};
+        digiConfig.conv_limit_en = false;
+        digiConfig.adc1_pattern_len = LIGHT_CHANNELS;
+        digiConfig.adc1_pattern = pattern;
+        digiConfig.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+        digiConfig.format = ADC_DIGI_FORMAT_12BIT;
+        adc_digi_controller_config(&digiConfig);
+
+        if (i2s_adc_enable(LIGHT_I2S_PORT) != ESP_OK) {
+            Serial.println("ERROR: ADC DMA enable failed");
+            return false;
+        }
+        if (!sky.tracking()) {
+            applyRate(false);   // Restored sky is not trackable; the task is not running yet
+        }
+
+        xTaskCreatePinnedToCore(samplerTask, "LightSampler", LIGHT_SAMPLER_STACK, this,
+                                LIGHT_SAMPLER_PRIO, &task, LIGHT_SAMPLER_CORE);
+
+        Serial.printf("Light sampler started: %u S/s, %u snapshots/s\n", sampleRate, rateHz);
+        return true;
+    }
+
+    /**
+     * @brief Seed the sky condition, e.g. from before a deep sleep
+     * Call before begin().
+     */
+    void restoreSky(SkyCondition condition) {
+        sky.restore(condition);
+    }
+
+    /**
+     * @brief Replace the per-channel gain/offset applied to every snapshot
+     * Call from a single task; takes effect from the next window.
+     * @param cal New calibration
+     */
+    void setCalibration(const LightCalibration& cal) {
+        uint8_t next = activeCalibration.load(std::memory_order_relaxed) ^ 1;
+        calibration[next] = cal;
+        activeCalibration.store(next, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copy the most recent complete snapshot
+     * @param out Destination snapshot
+     * @return false if no window has completed yet
+     */
+    bool latest(LightSnapshot& out) const {
+        return ring.latest(out);
+    }
+
+    /**
+     * @brief Copy the next snapshot a consumer has not seen yet
+     * @param cursor Consumer's own position, start at 0
+     * @param out Destination snapshot
+     * @return false if the consumer is up to date
+     */
+    bool next(uint32_t& cursor, LightSnapshot& out) const {
+        return ring.next(cursor, out);
+    }
+};
+
+constexpr int8_t LightSampler::channelMap[8];
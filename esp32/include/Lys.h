@@ -5,10 +5,17 @@
  * 
  * Manages light sensor readings, ADC configuration, and sun direction detection
  * for the dual-axis solar tracking system.
+ *
+ * The per-channel filter chain (oversample/decimate, median spike rejector,
+ * IIR low-pass) is integer-only and has no Arduino dependencies, so it also
+ * compiles in a native build.
  */
 
 #pragma once
 
+#include <stdint.h>
+
+#ifdef ARDUINO
 #include <Arduino.h>
 #include <driver/adc.h>
 #include "DisplayHandler.h"
@@ -16,9 +23,467 @@
 // ADC Configuration
 #define ADC_RESOLUTION ADC_WIDTH_BIT_12
 #define ADC_ATTENUATION ADC_ATTEN_DB_12
+#endif
+
 #define ADC_MAX_VALUE 4095
-#define ADC_REFERENCE_VOLTAGE 3.3
 
+// Filter Configuration
+#define LIGHT_OVERSAMPLE_SHIFT 4    // Average 2^4 = 16 raw samples per decimated sample
+#define LIGHT_MEDIAN_TAPS      5    // Median window in decimated samples (odd)
+#define LIGHT_FILTER_TAU_MS    200  // Low-pass time constant
+#define LIGHT_FRAC_BITS        4    // Fraction bits of filtered values (Q4 of 12-bit ADC)
+#define LIGHT_IIR_GUARD_BITS   8    // Extra IIR state bits so small steps never stall
+
+// Calibration Configuration
+#define LIGHT_GAIN_SHIFT       12   // Gains are Q12: 4096 = 1.0
+#define LIGHT_GAIN_MAX         (4 << LIGHT_GAIN_SHIFT)
+#define LIGHT_CAL_MIN_SPAN     (100 << LIGHT_FRAC_BITS)    // Smallest usable light - dark span
+
+// Error Vector Configuration
+#define SUN_ERROR_SHIFT        12   // Errors and confidence are Q12: 4096 = 1.0
+#define SUN_CONFIDENCE_FULL    4000 // Total irradiance (sum of 12-bit channels) for full confidence
+
+// Sky Condition Configuration (irradiance = sum of the four 12-bit channels)
+#define SKY_NIGHT_ENTER            120
+#define SKY_NIGHT_EXIT             200
+#define SKY_OVERCAST_ENTER         1200
+#define SKY_OVERCAST_EXIT          1600
+#define SKY_OVERCAST_HYSTERESIS    (SKY_OVERCAST_EXIT - SKY_OVERCAST_ENTER)
+#define SKY_DIFFUSE_MAX_IRRADIANCE 8000 // Above this a balanced reading means "on target"
+#define SKY_DIFFUSE_SPREAD_ENTER   160  // Q12 error (~4%)
+#define SKY_DIFFUSE_SPREAD_EXIT    320  // Q12 error (~8%)
+#define SKY_HOLD_MS                5000 // A new condition must persist this long
+
+/**
+ * @brief Light channel order used by all snapshots
+ */
+enum LightChannel {
+    LIGHT_LEFT = 0,
+    LIGHT_RIGHT,
+    LIGHT_UP,
+    LIGHT_DOWN,
+    LIGHT_CHANNELS
+};
+
+/**
+ * @brief Oversampling decimator
+ *
+ * Sums 2^shift raw 12-bit samples and emits their mean with LIGHT_FRAC_BITS
+ * fraction bits, so oversampling shows up as added resolution.
+ */
+class LightDecimator {
+private:
+    uint32_t sum = 0;
+    uint16_t count = 0;
+    uint8_t shift;
+
+public:
+    explicit LightDecimator(uint8_t oversampleShift = LIGHT_OVERSAMPLE_SHIFT)
+        : shift(oversampleShift) {}
+
+    /**
+     * @brief Add one raw sample
+     * @param raw 12-bit ADC value
+     * @param out Receives the decimated Q4 value when one is complete
+     * @return true when out was written
+     */
+    bool push(uint16_t raw, uint16_t& out) {
+        sum += raw;
+        if (++count < (1u << shift)) {
+            return false;
+        }
+
+        out = shift >= LIGHT_FRAC_BITS ? sum >> (shift - LIGHT_FRAC_BITS)
+                                       : sum << (LIGHT_FRAC_BITS - shift);
+        sum = 0;
+        count = 0;
+        return true;
+    }
+};
+
+/**
+ * @brief Median-of-N spike rejector over the last N decimated samples
+ */
+template <uint8_t N = LIGHT_MEDIAN_TAPS>
+class LightMedian {
+    static_assert(N % 2 == 1, "Median window must be odd");
+
+private:
+    uint16_t window[N] = {};
+    uint8_t next = 0;
+    uint8_t filled = 0;
+
+public:
+    /**
+     * @brief Add a sample and return the median of the current window
+     * @param x New sample
+     * @return Median of the samples seen so far (up to N)
+     */
+    uint16_t push(uint16_t x) {
+        window[next] = x;
+        next = (next + 1) % N;
+        if (filled < N) {
+            filled++;
+        }
+
+        // Insertion sort of a copy; N is tiny
+        uint16_t sorted[N];
+        for (uint8_t i = 0; i < filled; i++) {
+            uint16_t v = window[i];
+            uint8_t j = i;
+            while (j > 0 && sorted[j - 1] > v) {
+                sorted[j] = sorted[j - 1];
+                j--;
+            }
+            sorted[j] = v;
+        }
+        return sorted[filled / 2];
+    }
+};
+
+/**
+ * @brief First-order IIR low-pass, y += (x - y) / 2^k
+ *
+ * The time constant is about 2^k samples; k is chosen from the requested
+ * time constant and the input rate when the filter is configured.
+ */
+class LightLowPass {
+private:
+    int32_t state = -1;     // Q(FRAC + GUARD), -1 until the first sample
+    uint8_t k = 0;
+
+public:
+    /**
+     * @brief Set the time constant
+     * @param tauMs Time constant in milliseconds
+     * @param rateHz Input sample rate
+     */
+    void configure(uint32_t tauMs, uint32_t rateHz) {
+        uint32_t samples = (tauMs * rateHz + 500) / 1000;
+        k = 0;
+        while (k < 15 && (1u << k) < samples) {
+            k++;
+        }
+    }
+
+    /**
+     * @brief Filter one sample
+     * @param x Q4 input
+     * @return Q4 output
+     */
+    uint16_t push(uint16_t x) {
+        int32_t in = (int32_t)x << LIGHT_IIR_GUARD_BITS;
+
+        if (state < 0) {
+            state = in;  // Start settled instead of ramping up from zero
+        } else {
+            state += (in - state) >> k;
+        }
+        return (uint16_t)((state + (1 << (LIGHT_IIR_GUARD_BITS - 1))) >> LIGHT_IIR_GUARD_BITS);
+    }
+};
+
+/**
+ * @brief Complete per-channel chain: decimate, median, low-pass
+ */
+class LightFilter {
+private:
+    LightDecimator decimator;
+    LightMedian<> median;
+    LightLowPass lowPass;
+    uint16_t output = 0;    // Q4
+
+public:
+    /**
+     * @brief Configure for a raw per-channel sample rate
+     * @param rawRateHz Raw samples per second on this channel
+     * @param tauMs Low-pass time constant in milliseconds
+     */
+    void configure(uint32_t rawRateHz, uint32_t tauMs = LIGHT_FILTER_TAU_MS) {
+        lowPass.configure(tauMs, rawRateHz >> LIGHT_OVERSAMPLE_SHIFT);
+    }
+
+    /**
+     * @brief Feed one raw 12-bit sample
+     * @return true when the output was updated
+     */
+    bool push(uint16_t raw) {
+        uint16_t decimated;
+        if (!decimator.push(raw, decimated)) {
+            return false;
+        }
+        output = lowPass.push(median.push(decimated));
+        return true;
+    }
+
+    /**
+     * @brief Filtered value with LIGHT_FRAC_BITS fraction bits
+     */
+    uint16_t valueQ4() const {
+        return output;
+    }
+
+    /**
+     * @brief Filtered value rounded to the 12-bit ADC scale
+     */
+    uint16_t value() const {
+        return (output + (1 << (LIGHT_FRAC_BITS - 1))) >> LIGHT_FRAC_BITS;
+    }
+};
+
+/**
+ * @brief Per-channel offset and gain that match the four sensors
+ *
+ * The offset is the channel's dark reading; the gain scales its
+ * dark-to-uniform-light span onto the mean span of all channels, so the
+ * sensors read alike under the same light.
+ */
+struct LightCalibration {
+    uint16_t offset[LIGHT_CHANNELS];    // Q4, subtracted first
+    uint16_t gain[LIGHT_CHANNELS];      // Q12
+
+    LightCalibration() {
+        for (int i = 0; i < LIGHT_CHANNELS; i++) {
+            offset[i] = 0;
+            gain[i] = 1 << LIGHT_GAIN_SHIFT;
+        }
+    }
+
+    /**
+     * @brief Correct one filtered reading
+     * @param channel LightChannel
+     * @param q4 Filtered value with LIGHT_FRAC_BITS fraction bits
+     * @return Corrected Q4 value, clamped to the ADC range
+     */
+    uint16_t apply(int channel, uint16_t q4) const {
+        if (q4 <= offset[channel]) {
+            return 0;
+        }
+
+        uint32_t corrected = ((uint32_t)(q4 - offset[channel]) * gain[channel]
+                              + (1u << (LIGHT_GAIN_SHIFT - 1))) >> LIGHT_GAIN_SHIFT;
+        const uint32_t limit = (uint32_t)ADC_MAX_VALUE << LIGHT_FRAC_BITS;
+        return corrected > limit ? limit : corrected;
+    }
+
+    /**
+     * @brief Compute calibration from dark and uniform-light captures
+     * @param dark Filtered Q4 per channel with the sensors covered
+     * @param light Filtered Q4 per channel under uniform illumination
+     * @return false if a channel's span is too small to trust
+     */
+    bool compute(const uint16_t dark[LIGHT_CHANNELS], const uint16_t light[LIGHT_CHANNELS]) {
+        uint32_t span[LIGHT_CHANNELS];
+        uint32_t total = 0;
+
+        for (int i = 0; i < LIGHT_CHANNELS; i++) {
+            if (light[i] < dark[i] + LIGHT_CAL_MIN_SPAN) {
+                return false;
+            }
+            span[i] = light[i] - dark[i];
+            total += span[i];
+        }
+
+        uint32_t target = total / LIGHT_CHANNELS;
+        for (int i = 0; i < LIGHT_CHANNELS; i++) {
+            uint32_t g = ((target << LIGHT_GAIN_SHIFT) + span[i] / 2) / span[i];
+            offset[i] = dark[i];
+            gain[i] = g > LIGHT_GAIN_MAX ? LIGHT_GAIN_MAX : g;
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief Differential sun position error from the four light channels
+ *
+ * Azimuth is (L - R) / (L + R), positive when the sun is to the left;
+ * elevation is (U - D) / (U + D), positive when the sun is above.
+ */
+struct SunError {
+    int16_t azimuth;        // Q12, -4096..4096
+    int16_t elevation;      // Q12, -4096..4096
+    uint16_t irradiance;    // Sum of the four 12-bit channels
+    uint16_t confidence;    // Q12, 0..4096; scales with irradiance
+};
+
+/**
+ * @brief Normalized difference (a - b) / (a + b) in Q12
+ */
+static inline int16_t sunErrorRatio(uint32_t a, uint32_t b) {
+    uint32_t sum = a + b;
+    if (sum == 0) {
+        return 0;
+    }
+    return (int16_t)((((int32_t)a - (int32_t)b) * (1 << SUN_ERROR_SHIFT)) / (int32_t)sum);
+}
+
+/**
+ * @brief Compute the error vector from one set of channel readings
+ * @param value 12-bit reading per LightChannel
+ * @return Error vector
+ */
+static inline SunError computeSunError(const uint16_t value[LIGHT_CHANNELS]) {
+    SunError e;
+    uint32_t total = (uint32_t)value[LIGHT_LEFT] + value[LIGHT_RIGHT] +
+                     value[LIGHT_UP] + value[LIGHT_DOWN];
+
+    e.azimuth = sunErrorRatio(value[LIGHT_LEFT], value[LIGHT_RIGHT]);
+    e.elevation = sunErrorRatio(value[LIGHT_UP], value[LIGHT_DOWN]);
+    e.irradiance = (uint16_t)total;
+    e.confidence = total >= SUN_CONFIDENCE_FULL
+                       ? 1 << SUN_ERROR_SHIFT
+                       : (uint16_t)((total << SUN_ERROR_SHIFT) / SUN_CONFIDENCE_FULL);
+    return e;
+}
+
+/**
+ * @brief Direction codes, in the order of the legacy names
+ */
+enum SunDirection : uint8_t {
+    SUN_LEFT = 0,
+    SUN_RIGHT,
+    SUN_UP,
+    SUN_DOWN
+};
+
+/**
+ * @brief Dominant direction of an error vector
+ * The axis with the larger error wins; its sign picks the direction.
+ */
+static inline SunDirection sunDirectionCode(const SunError& e) {
+    int az = e.azimuth < 0 ? -e.azimuth : e.azimuth;
+    int el = e.elevation < 0 ? -e.elevation : e.elevation;
+
+    if (az >= el) {
+        return e.azimuth >= 0 ? SUN_LEFT : SUN_RIGHT;
+    }
+    return e.elevation >= 0 ? SUN_UP : SUN_DOWN;
+}
+
+/**
+ * @brief Legacy direction name for an error vector
+ * @return "Venstre", "Højre", "Op" or "Ned"
+ */
+static inline const char* sunDirectionName(const SunError& e) {
+    static const char* const names[] = {"Venstre", "Højre", "Op", "Ned"};
+    return names[sunDirectionCode(e)];
+}
+
+/**
+ * @brief Sky condition, ordered from best to worst tracking light
+ */
+enum SkyCondition : uint8_t {
+    SKY_CLEAR = 0,      // Directional sun, track normally
+    SKY_DIFFUSE,        // Moderate light with no usable direction
+    SKY_OVERCAST,       // Low light
+    SKY_NIGHT           // Dark
+};
+
+/**
+ * @brief Printable name of a sky condition
+ */
+static inline const char* skyConditionName(uint8_t sky) {
+    static const char* const names[] = {"clear", "diffuse", "overcast", "night"};
+    return sky <= SKY_NIGHT ? names[sky] : "unknown";
+}
+
+/**
+ * @brief Classifies clear/diffuse/overcast/night with hysteresis
+ *
+ * Each threshold has separate enter and exit levels, and a changed
+ * classification only takes effect once it has held for SKY_HOLD_MS, so
+ * a passing cloud edge does not toggle tracking on and off.
+ */
+class SkyClassifier {
+private:
+    SkyCondition state = SKY_CLEAR;
+    SkyCondition pending = SKY_CLEAR;
+    uint32_t pendingSinceMs = 0;
+    uint16_t overcastEnter = SKY_OVERCAST_ENTER;
+
+    static bool below(uint32_t value, uint32_t enter, uint32_t exit, bool inState) {
+        return value < (inState ? exit : enter);
+    }
+
+    SkyCondition instant(const SunError& e) const {
+        int az = e.azimuth < 0 ? -e.azimuth : e.azimuth;
+        int el = e.elevation < 0 ? -e.elevation : e.elevation;
+        uint32_t spread = az > el ? az : el;
+
+        if (below(e.irradiance, SKY_NIGHT_ENTER, SKY_NIGHT_EXIT, state >= SKY_NIGHT)) {
+            return SKY_NIGHT;
+        }
+        if (below(e.irradiance, overcastEnter, overcastEnter + SKY_OVERCAST_HYSTERESIS,
+                  state >= SKY_OVERCAST)) {
+            return SKY_OVERCAST;
+        }
+        if (e.irradiance < SKY_DIFFUSE_MAX_IRRADIANCE &&
+            below(spread, SKY_DIFFUSE_SPREAD_ENTER, SKY_DIFFUSE_SPREAD_EXIT, state >= SKY_DIFFUSE)) {
+            return SKY_DIFFUSE;
+        }
+        return SKY_CLEAR;
+    }
+
+public:
+    /**
+     * @brief Start from a condition known from before a restart
+     *
+     * A different condition must still persist SKY_HOLD_MS to replace it,
+     * so a wake at dawn does not start tracking on its first reading.
+     */
+    void restore(SkyCondition condition) {
+        state = condition;
+        pending = condition;
+    }
+
+    /**
+     * @brief Move the overcast threshold (the exit level keeps its hysteresis)
+     * @param enter Irradiance below which the sky counts as overcast
+     */
+    void setOvercastThreshold(uint16_t enter) {
+        overcastEnter = enter;
+    }
+
+    /**
+     * @brief Feed one error vector
+     * @param e Current error vector
+     * @param nowMs Monotonic time in milliseconds
+     * @return true if the condition changed
+     */
+    bool update(const SunError& e, uint32_t nowMs) {
+        SkyCondition candidate = instant(e);
+
+        if (candidate == state) {
+            pending = state;
+            return false;
+        }
+        if (candidate != pending) {
+            pending = candidate;
+            pendingSinceMs = nowMs;
+            return false;
+        }
+        if (nowMs - pendingSinceMs < SKY_HOLD_MS) {
+            return false;
+        }
+
+        state = candidate;
+        return true;
+    }
+
+    SkyCondition condition() const {
+        return state;
+    }
+
+    /**
+     * @brief Whether the light supports issuing move commands
+     */
+    bool tracking() const {
+        return state == SKY_CLEAR;
+    }
+};
+
+#ifdef ARDUINO
 class LightSensor {
 private:
     int sensorPin;
@@ -47,32 +512,48 @@ public:
     }
 
     /**
-     * @brief Read and display light intensity on TFT
+     * @brief Display light intensity on TFT
      * @param display DisplayHandler object reference
+     * @param sensorValue Sampled ADC value for this sensor
+     * @param millivolts Calibrated voltage of sensorValue (see AdcCalibration.h)
      * @param x X coordinate on display
      * @param y Y coordinate on display
      */
-    void logLightIntensity(DisplayHandler& display, int x, int y) {
-        int sensorValue = analogRead(sensorPin);
-        float voltage = (sensorValue * ADC_REFERENCE_VOLTAGE) / ADC_MAX_VALUE;
-
+    void logLightIntensity(DisplayHandler& display, int sensorValue, int millivolts, int x, int y) {
         // Determine sensor position label
-        String label;
+        const char* label = "";
         if (sensorPin == 32) label = "Left ";
         else if (sensorPin == 33) label = "Right";
         else if (sensorPin == 39) label = "Up   ";
         else if (sensorPin == 36) label = "Down ";
 
-        display.showData(label.c_str(), sensorValue, voltage, x, y);
+        display.showData(label, sensorValue, millivolts, x, y);
 
         // Log to serial for debugging
         if (sensorValue > 3000) {
-            Serial.printf("%s sensor: HIGH intensity (%d)\n", label.c_str(), sensorValue);
+            Serial.printf("%s sensor: HIGH intensity (%d)\n", label, sensorValue);
         } else if (sensorValue < 1000) {
-            Serial.printf("%s sensor: LOW intensity (%d)\n", label.c_str(), sensorValue);
+            Serial.printf("%s sensor: LOW intensity (%d)\n", label, sensorValue);
         }
     }
 
+    /**
+     * @brief Compute the sun error vector from sensor values
+     * @param left Left sensor value
+     * @param right Right sensor value
+     * @param up Up sensor value
+     * @param down Down sensor value
+     * @return Differential error, irradiance and confidence
+     */
+    SunError getSunError(uint16_t left, uint16_t right, uint16_t up, uint16_t down) {
+        uint16_t value[LIGHT_CHANNELS];
+        value[LIGHT_LEFT] = left;
+        value[LIGHT_RIGHT] = right;
+        value[LIGHT_UP] = up;
+        value[LIGHT_DOWN] = down;
+        return computeSunError(value);
+    }
+
     /**
      * @brief Determine sun direction based on sensor values
      * @param left Left sensor value
@@ -81,25 +562,8 @@ public:
      * @param down Down sensor value
      * @return Direction string: "Venstre", "Højre", "Op", or "Ned"
      */
-    String getSunDirection(int left, int right, int up, int down) {
-        int maxIntensity = left;
-        String direction = "Venstre";  // Left
-
-        if (right > maxIntensity) {
-            maxIntensity = right;
-            direction = "Højre";  // Right
-        }
-        if (up > maxIntensity) {
-            maxIntensity = up;
-            direction = "Op";  // Up
-        }
-        if (down > maxIntensity) {
-            maxIntensity = down;
-            direction = "Ned";  // Down
-        }
-
-        Serial.printf("Max intensity direction: %s (%d)\n", direction.c_str(), maxIntensity);
-        return direction;
+    const char* getSunDirection(int left, int right, int up, int down) {
+        return sunDirectionName(getSunError(left, right, up, down));
     }
 
     /**
@@ -111,8 +575,9 @@ public:
      * @param display DisplayHandler object reference
      */
     void Sunsearch(int left, int right, int up, int down, DisplayHandler& display) {
-        String direction = getSunDirection(left, right, up, down);
+        const char* direction = getSunDirection(left, right, up, down);
         int maxIntensity = max(max(left, right), max(up, down));
         display.showDirection(direction, maxIntensity, 10, 100);
     }
 };
+#endif
@@ -0,0 +1,255 @@
+/**
+ * @file MqttPublisher.h
+ * @brief Batched telemetry to an MQTT broker, thresholds from a config topic
+ * @author Yahya
+ *
+ * Instead of a central collector polling every tracker over HTTP, each
+ * ESP32 keeps one connection to a broker and publishes a batch of
+ * MQTT_BATCH_SAMPLES telemetry frames at a time:
+ *
+ *   <prefix>/<id>/telemetry     count x 24-byte TelemetryFrame (Telemetry.h)
+ *   <prefix>/<id>/status        "online", retained; "offline" as last will
+ *   <prefix>/<id>/config        thresholds, same fields as POST /setpoint
+ *   <prefix>/all/config         thresholds for the whole fleet
+ *   <prefix>/<id>/config/ack    "ok" or the reason a config was rejected
+ *
+ * <id> is the station MAC address in hex. Config messages use the form
+ * encoding, e.g. "setpoint=5&minLimit=1500".
+ *
+ * Finished batches wait in a fixed RAM ring until the client is
+ * connected; while offline the ring fills and then drops the oldest batch,
+ * so an outage costs memory only up to MQTT_QUEUE_BATCHES. After a
+ * reconnect the backlog is handed to the client a few batches per tick.
+ * With QoS 1 the client keeps unacknowledged batches in its outbox and
+ * resends them, so a collector may see duplicates (frames carry their
+ * timestamp); QoS 0 sends each batch at most once.
+ *
+ * Uses the esp-mqtt client that ships with ESP-IDF; no extra library.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <atomic>
+#include <mqtt_client.h>
+#include "Telemetry.h"
+#include "TrackingConfig.h"
+
+// MQTT Configuration (override with build_flags, e.g. -D MQTT_BROKER_URI=\"mqtt://192.168.1.10\")
+#ifndef MQTT_BROKER_URI
+#define MQTT_BROKER_URI         ""          // Empty disables MQTT
+#endif
+#ifndef MQTT_QOS
+#define MQTT_QOS                1           // Telemetry QoS, 0 or 1
+#endif
+#ifndef MQTT_TOPIC_PREFIX
+#define MQTT_TOPIC_PREFIX       "solar"
+#endif
+#define MQTT_BATCH_SAMPLES      10          // Frames per message
+#define MQTT_SAMPLE_INTERVAL    1000        // milliseconds between frames
+#define MQTT_QUEUE_BATCHES      32          // Offline backlog (~5 min at the defaults)
+#define MQTT_FLUSH_BATCHES      4           // Batches handed to the client per tick
+#define MQTT_KEEPALIVE_S        30
+#define MQTT_TOPIC_MAX          64
+#define MQTT_CONFIG_MAX         96
+
+/**
+ * @brief One message worth of telemetry frames
+ */
+struct TelemetryBatch {
+    uint8_t count;
+    TelemetryFrame frames[MQTT_BATCH_SAMPLES];
+};
+
+class MqttPublisher {
+private:
+    esp_mqtt_client_handle_t client = nullptr;
+    TrackingConfigStore* configStore = nullptr;
+    std::atomic<bool> connected{false};
+
+    char clientId[24];
+    char telemetryTopic[MQTT_TOPIC_MAX];
+    char statusTopic[MQTT_TOPIC_MAX];
+    char configTopic[MQTT_TOPIC_MAX];
+    char fleetConfigTopic[MQTT_TOPIC_MAX];
+    char ackTopic[MQTT_TOPIC_MAX];
+
+    // Owned by the publisher task
+    TelemetryBatch queue[MQTT_QUEUE_BATCHES];
+    uint32_t head = 0;                  // Batches ever queued
+    uint32_t tail = 0;                  // Batches handed to the client
+    TelemetryBatch current = {};
+
+    std::atomic<uint32_t> published{0};
+    std::atomic<uint32_t> dropped{0};
+
+    static bool topicIs(const esp_mqtt_event_handle_t event, const char* topic) {
+        return event->topic_len == (int)strlen(topic) && memcmp(event->topic, topic, event->topic_len) == 0;
+    }
+
+    /**
+     * @brief Apply a message from a config topic (MQTT task)
+     */
+    void handleConfig(const esp_mqtt_event_handle_t event) {
+        char text[MQTT_CONFIG_MAX];
+        const char* error = "message too long";
+
+        if (event->total_data_len < (int)sizeof(text) && event->current_data_offset == 0) {
+            memcpy(text, event->data, event->data_len);
+            text[event->data_len] = '\0';
+
+            error = configStore->update([&text](TrackingConfig& config) {
+                return config.setFields(text) ? nullptr : "fields must be setpoint, maxLimit, minLimit";
+            });
+        }
+
+        Serial.printf("MQTT config: %s\n", error ? error : "applied");
+        esp_mqtt_client_enqueue(client, ackTopic, error ? error : "ok", 0, 1, 0, true);
+    }
+
+    static void onEvent(void* arg, esp_event_base_t base, int32_t id, void* data) {
+        MqttPublisher* self = static_cast<MqttPublisher*>(arg);
+        esp_mqtt_event_handle_t event = static_cast<esp_mqtt_event_handle_t>(data);
+
+        switch ((esp_mqtt_event_id_t)id) {
+        case MQTT_EVENT_CONNECTED:
+            esp_mqtt_client_subscribe(self->client, self->configTopic, 1);
+            esp_mqtt_client_subscribe(self->client, self->fleetConfigTopic, 1);
+            esp_mqtt_client_enqueue(self->client, self->statusTopic, "online", 0, 1, 1, true);
+            self->connected.store(true, std::memory_order_release);
+            Serial.println("MQTT connected");
+            break;
+        case MQTT_EVENT_DISCONNECTED:
+            self->connected.store(false, std::memory_order_release);
+            Serial.println("MQTT disconnected");
+            break;
+        case MQTT_EVENT_DATA:
+            if (topicIs(event, self->configTopic) || topicIs(event, self->fleetConfigTopic)) {
+                self->handleConfig(event);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+public:
+    /**
+     * @brief Start the client; it connects and reconnects in its own task
+     * @param uri Broker URI, e.g. "mqtt://192.168.1.10"; empty disables MQTT
+     * @param store Where accepted config messages are applied
+     * @return false if MQTT is disabled or the client could not start
+     */
+    bool begin(const char* uri, TrackingConfigStore& store) {
+        if (!uri || uri[0] == '\0') {
+            return false;
+        }
+        configStore = &store;
+
+        uint8_t mac[6];
+        char id[13];
+        WiFi.macAddress(mac);
+        snprintf(id, sizeof(id), "%02x%02x%02x%02x%02x%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+        snprintf(clientId, sizeof(clientId), "solar-%s", id);
+        snprintf(telemetryTopic, sizeof(telemetryTopic), "%s/%s/telemetry", MQTT_TOPIC_PREFIX, id);
+        snprintf(statusTopic, sizeof(statusTopic), "%s/%s/status", MQTT_TOPIC_PREFIX, id);
+        snprintf(configTopic, sizeof(configTopic), "%s/%s/config", MQTT_TOPIC_PREFIX, id);
+        snprintf(fleetConfigTopic, sizeof(fleetConfigTopic), "%s/all/config", MQTT_TOPIC_PREFIX);
+        snprintf(ackTopic, sizeof(ackTopic), "%s/%s/config/ack", MQTT_TOPIC_PREFIX, id);
+
+        esp_mqtt_client_config_t cfg = {};
+#if ESP_IDF_VERSION_MAJOR >= 5
+        cfg.broker.address.uri = uri;
+        cfg.credentials.client_id = clientId;
+        cfg.session.keepalive = MQTT_KEEPALIVE_S;
+        cfg.session.last_will.topic = statusTopic;
+        cfg.session.last_will.msg = "offline";
+        cfg.session.last_will.qos = 1;
+        cfg.session.last_will.retain = 1;
+#else
+        cfg.uri = uri;
+        cfg.client_id = clientId;
+        cfg.keepalive = MQTT_KEEPALIVE_S;
+        cfg.lwt_topic = statusTopic;
+        cfg.lwt_msg = "offline";
+        cfg.lwt_qos = 1;
+        cfg.lwt_retain = 1;
+#endif
+
+        client = esp_mqtt_client_init(&cfg);
+        if (!client) {
+            Serial.println("ERROR: MQTT client init failed");
+            return false;
+        }
+        esp_mqtt_client_register_event(client, (esp_mqtt_event_id_t)ESP_EVENT_ANY_ID, onEvent, this);
+        if (esp_mqtt_client_start(client) != ESP_OK) {
+            Serial.println("ERROR: MQTT client start failed");
+            return false;
+        }
+
+        Serial.printf("MQTT: %s as %s, QoS %d, %d frames per batch\n",
+                      uri, clientId, MQTT_QOS, MQTT_BATCH_SAMPLES);
+        return true;
+    }
+
+    /**
+     * @brief Add one frame; every MQTT_BATCH_SAMPLES frames a batch is queued
+     * Publisher task only.
+     */
+    void addSample(const TelemetryFrame& frame) {
+        current.frames[current.count++] = frame;
+        if (current.count < MQTT_BATCH_SAMPLES) {
+            return;
+        }
+
+        if (head - tail == MQTT_QUEUE_BATCHES) {
+            tail++;     // Full: the oldest batch makes room
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        queue[head % MQTT_QUEUE_BATCHES] = current;
+        head++;
+        current.count = 0;
+    }
+
+    /**
+     * @brief Hand queued batches to the client while connected
+     * Publisher task only. At most MQTT_FLUSH_BATCHES per call, so a
+     * backlog after a reconnect does not flood the client's outbox.
+     */
+    void flush() {
+        for (int i = 0; i < MQTT_FLUSH_BATCHES && tail != head; i++) {
+            if (!connected.load(std::memory_order_acquire)) {
+                return;
+            }
+            const TelemetryBatch& batch = queue[tail % MQTT_QUEUE_BATCHES];
+            int id = esp_mqtt_client_enqueue(client, telemetryTopic,
+                                             reinterpret_cast<const char*>(batch.frames),
+                                             batch.count * sizeof(TelemetryFrame), MQTT_QOS, 0, true);
+            if (id < 0) {
+                return;     // Client outbox full; retry next tick
+            }
+            tail++;
+            published.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    bool isConnected() const {
+        return connected.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Batches waiting for a connection (approximate from other tasks)
+     */
+    uint32_t backlog() const {
+        return head - tail;
+    }
+
+    uint32_t publishedBatches() const {
+        return published.load(std::memory_order_relaxed);
+    }
+
+    uint32_t droppedBatches() const {
+        return dropped.load(std::memory_order_relaxed);
+    }
+};
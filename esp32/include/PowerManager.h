@@ -0,0 +1,222 @@
+/**
+ * @file PowerManager.h
+ * @brief Night deep sleep, fast wake and daytime power saving
+ * @author Yahya
+ *
+ * After the sky has been classified as night for a while the ESP32 goes
+ * into deep sleep and wakes on a timer. A timer wake first does a one-shot
+ * light check before anything else is started: still dark means straight
+ * back to sleep, so the night costs a few milliseconds per wake. The sky
+ * condition, sensor calibration and the last WiFi BSSID/channel live in
+ * RTC memory, so a wake at dawn resumes from "night" instead of tracking
+ * on its first reading, reconnects without a scan and skips the NVS read
+ * and the full HandleWiFi_init() sequence.
+ *
+ * During the day the CPU runs with dynamic frequency scaling and, when the
+ * SDK is built with tickless idle, automatic light sleep between samples.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_sleep.h>
+#include <esp_pm.h>
+#include <driver/adc.h>
+#include "Lys.h"
+#include "LightSampler.h"
+
+// Power Configuration
+#define POWER_NIGHT_CONFIRM_MS  (10UL * 60 * 1000)  // Night must persist this long before sleeping
+#define POWER_NIGHT_SLEEP_S     (30UL * 60)         // Timer wake interval through the night
+#define POWER_FAST_CONNECT_MS   3000                // Give up on the cached AP after this
+#define POWER_CPU_MAX_MHZ       240
+#define POWER_CPU_MIN_MHZ       80
+#define POWER_RTC_MAGIC         0x50574D31          // "PWM1"
+
+/**
+ * @brief State kept in RTC slow memory across deep sleep
+ *
+ * Plain data only: RTC_DATA_ATTR variables are zeroed on a cold boot and
+ * must not have constructors, which would run again after every wake.
+ */
+struct PowerRtcState {
+    uint32_t magic;
+    uint32_t bootCount;
+    uint32_t darkWakes;                 // Timer wakes that found it still dark
+    uint8_t bssid[6];
+    int32_t channel;
+    bool wifiValid;
+    bool calibrationValid;
+    uint16_t calibrationOffset[LIGHT_CHANNELS];
+    uint16_t calibrationGain[LIGHT_CHANNELS];
+    uint8_t lastSky;                    // SkyCondition of the last snapshot before sleep or reset
+};
+
+RTC_DATA_ATTR static PowerRtcState powerRtcState;
+
+class PowerManager {
+private:
+    esp_sleep_wakeup_cause_t wakeCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+    uint32_t nightSinceMs = 0;
+    bool night = false;
+    bool warm = false;                  // RTC state survived from an earlier boot
+
+public:
+    /**
+     * @brief Record the wake reason and enable daytime power saving
+     * Call early in setup(), before the light sampler starts.
+     */
+    void begin() {
+        wakeCause = esp_sleep_get_wakeup_cause();
+
+        warm = powerRtcState.magic == POWER_RTC_MAGIC;
+        if (!warm) {
+            memset(&powerRtcState, 0, sizeof(powerRtcState));
+            powerRtcState.magic = POWER_RTC_MAGIC;
+        }
+        powerRtcState.bootCount++;
+
+#if CONFIG_PM_ENABLE
+        esp_pm_config_esp32_t pm = {};
+        pm.max_freq_mhz = POWER_CPU_MAX_MHZ;
+        pm.min_freq_mhz = POWER_CPU_MIN_MHZ;
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+        pm.light_sleep_enable = true;
+#endif
+        if (esp_pm_configure(&pm) != ESP_OK) {
+            Serial.println("WARNING: Power management not configured");
+        }
+#endif
+
+        Serial.printf("Power: boot %u, wake cause %d\n", powerRtcState.bootCount, wakeCause);
+    }
+
+    /**
+     * @brief Whether this boot is a timer wake from night sleep
+     */
+    bool wokeFromNight() const {
+        return wakeCause == ESP_SLEEP_WAKEUP_TIMER;
+    }
+
+    /**
+     * @brief One-shot dark check before the sampler runs
+     * Requires the ADC channels to be configured (LightSensor::initLight).
+     * @return true if total irradiance is still below the night exit level
+     */
+    bool stillDark() const {
+        uint32_t total = adc1_get_raw(ADC1_CHANNEL_4) + adc1_get_raw(ADC1_CHANNEL_5) +
+                         adc1_get_raw(ADC1_CHANNEL_3) + adc1_get_raw(ADC1_CHANNEL_0);
+        return total < SKY_NIGHT_EXIT;
+    }
+
+    /**
+     * @brief Enter deep sleep until the next night timer wake
+     */
+    [[noreturn]] void enterNightSleep() {
+        if (wokeFromNight()) {
+            powerRtcState.darkWakes++;
+        }
+        Serial.printf("Power: night, sleeping %lu s\n", POWER_NIGHT_SLEEP_S);
+        Serial.flush();
+
+        esp_sleep_enable_timer_wakeup((uint64_t)POWER_NIGHT_SLEEP_S * 1000000ULL);
+        esp_deep_sleep_start();
+    }
+
+    /**
+     * @brief Feed the newest light snapshot (call periodically)
+     * @param light Current snapshot
+     * @return true once night has persisted long enough to sleep
+     */
+    bool update(const LightSnapshot& light) {
+        powerRtcState.lastSky = light.sky;
+
+        if (light.sky != SKY_NIGHT) {
+            night = false;
+            return false;
+        }
+        if (!night) {
+            night = true;
+            nightSinceMs = light.timestampMs;
+        }
+        return light.timestampMs - nightSinceMs >= POWER_NIGHT_CONFIRM_MS;
+    }
+
+    /**
+     * @brief Sky condition from before the deep sleep or reset
+     * @param out Receives the last condition update() saw
+     * @return false on a cold boot
+     */
+    bool restoreSky(SkyCondition& out) const {
+        if (!warm) {
+            return false;
+        }
+        out = (SkyCondition)powerRtcState.lastSky;
+        return true;
+    }
+
+    /**
+     * @brief Calibration cached in RTC memory
+     * @param out Receives the cached calibration
+     * @return false on a cold boot or before saveCalibration()
+     */
+    bool restoreCalibration(LightCalibration& out) const {
+        if (!powerRtcState.calibrationValid) {
+            return false;
+        }
+        memcpy(out.offset, powerRtcState.calibrationOffset, sizeof(out.offset));
+        memcpy(out.gain, powerRtcState.calibrationGain, sizeof(out.gain));
+        return true;
+    }
+
+    /**
+     * @brief Cache the calibration in RTC memory
+     */
+    void saveCalibration(const LightCalibration& cal) {
+        memcpy(powerRtcState.calibrationOffset, cal.offset, sizeof(cal.offset));
+        memcpy(powerRtcState.calibrationGain, cal.gain, sizeof(cal.gain));
+        powerRtcState.calibrationValid = true;
+    }
+
+    /**
+     * @brief Reconnect to the cached access point without scanning
+     * @param ssid WiFi network SSID
+     * @param password WiFi network password
+     * @return true if connected within POWER_FAST_CONNECT_MS
+     */
+    bool fastConnect(const char* ssid, const char* password) {
+        if (!powerRtcState.wifiValid) {
+            return false;
+        }
+
+        WiFi.mode(WIFI_STA);
+        WiFi.begin(ssid, password, powerRtcState.channel, powerRtcState.bssid, true);
+
+        uint32_t start = millis();
+        while (WiFi.status() != WL_CONNECTED) {
+            if (millis() - start >= POWER_FAST_CONNECT_MS) {
+                Serial.println("Power: cached AP not reachable, full connect");
+                powerRtcState.wifiValid = false;
+                WiFi.disconnect();
+                return false;
+            }
+            delay(10);
+        }
+
+        Serial.printf("Power: fast reconnect in %lu ms\n", millis() - start);
+        return true;
+    }
+
+    /**
+     * @brief Cache the connected AP's BSSID and channel for the next wake
+     */
+    void rememberWiFi() {
+        if (WiFi.status() != WL_CONNECTED) {
+            return;
+        }
+        memcpy(powerRtcState.bssid, WiFi.BSSID(), sizeof(powerRtcState.bssid));
+        powerRtcState.channel = WiFi.channel();
+        powerRtcState.wifiValid = true;
+    }
+};
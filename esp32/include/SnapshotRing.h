@@ -0,0 +1,112 @@
+/**
+ * @file SnapshotRing.h
+ * @brief Lock-free single-producer ring of fixed-size snapshots
+ * @author Yahya
+ *
+ * One task publishes, any number of tasks read. The producer never waits:
+ * when a reader falls more than the ring size behind, the oldest entries
+ * are simply overwritten and the reader skips forward. Every slot carries
+ * its own sequence number, odd while the slot is being written, so a
+ * reader that races the producer detects it and retries (seqlock style).
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+template <typename T, uint32_t N>
+class SnapshotRing {
+    static_assert((N & (N - 1)) == 0, "Ring size must be a power of two");
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> seq{0};   // 2 * index + 2 once written, odd while writing
+        T value;
+    };
+
+    Slot slots[N];
+    std::atomic<uint32_t> head{0};      // Number of entries ever published
+
+    /**
+     * @brief Copy entry `index` if it is still in its slot
+     */
+    bool copy(uint32_t index, T& out) const {
+        const Slot& slot = slots[index & (N - 1)];
+        const uint32_t expected = 2 * index + 2;
+
+        uint32_t before = slot.seq.load(std::memory_order_acquire);
+        if (before != expected) {
+            return false;
+        }
+        out = slot.value;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.seq.load(std::memory_order_relaxed) == expected;
+    }
+
+public:
+    /**
+     * @brief Publish one entry (producer task only, never blocks)
+     * @param value Entry to copy into the ring
+     */
+    void push(const T& value) {
+        uint32_t index = head.load(std::memory_order_relaxed);
+        Slot& slot = slots[index & (N - 1)];
+
+        slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.value = value;
+        slot.seq.store(2 * index + 2, std::memory_order_release);
+        head.store(index + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Number of entries published so far
+     */
+    uint32_t published() const {
+        return head.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Copy the newest entry
+     * @param out Destination
+     * @return false if nothing has been published yet
+     */
+    bool latest(T& out) const {
+        for (;;) {
+            uint32_t h = head.load(std::memory_order_acquire);
+            if (h == 0) {
+                return false;
+            }
+            if (copy(h - 1, out)) {
+                return true;
+            }
+        }
+    }
+
+    /**
+     * @brief Copy the next entry after a reader's cursor
+     *
+     * Each consumer keeps its own cursor (start at 0). A consumer that fell
+     * behind by more than N entries skips to the oldest entry still held.
+     *
+     * @param cursor Reader position, advanced past the returned entry
+     * @param out Destination
+     * @return false if the reader is up to date
+     */
+    bool next(uint32_t& cursor, T& out) const {
+        for (;;) {
+            uint32_t h = head.load(std::memory_order_acquire);
+            if (cursor == h) {
+                return false;
+            }
+            if (h - cursor > N - 1) {
+                cursor = h - (N - 1);   // Overrun: the slot after head may be mid-write
+            }
+            if (copy(cursor, out)) {
+                cursor++;
+                return true;
+            }
+        }
+    }
+};
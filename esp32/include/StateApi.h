@@ -0,0 +1,170 @@
+/**
+ * @file StateApi.h
+ * @brief Combined device state for /api/state, as JSON or CBOR
+ * @author Yahya
+ *
+ * Everything a client needs in one response: light channels, sun
+ * direction, sky, temperature, humidity, uptime, WiFi RSSI and the axis
+ * positions reported by the Pi. The caller collects the snapshots once;
+ * the body is serialized straight into a buffer inside the response
+ * object, so no String or intermediate document is built per request.
+ * Unknown values are null in both encodings.
+ *
+ * CBOR (RFC 8949) is chosen when the Accept header asks for
+ * application/cbor; it carries the same map with the same keys.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include "AxisLink.h"
+#include "CborWriter.h"
+#include "HTU.h"
+#include "LightSampler.h"
+#include "Lys.h"
+
+// State API Configuration
+#define STATE_BODY_MAX          256
+#define STATE_MIME_JSON         "application/json"
+#define STATE_MIME_CBOR         "application/cbor"
+
+/**
+ * @brief Snapshot of everything /api/state reports
+ */
+struct DeviceState {
+    LightSnapshot light;
+    EnvSnapshot env;
+    AxisSnapshot axis;
+    uint32_t uptimeSec;
+    int32_t rssi;
+    bool lightValid;
+    bool envValid;              // Recent and passed the CRC check
+    bool axisValid;             // Reported by the Pi within AXIS_STALE_MS
+    bool rssiValid;             // Connected to an access point
+};
+
+/**
+ * @brief Serialize the state as JSON
+ * @return Length, 0 if it did not fit
+ */
+static inline size_t formatStateJson(char* buf, size_t len, const DeviceState& s) {
+    char light[32] = "null";
+    char direction[12] = "null";
+    char sky[12] = "null";
+    char temperature[12] = "null";
+    char humidity[12] = "null";
+    char rssi[8] = "null";
+    char axis[48] = "null";
+
+    if (s.lightValid) {
+        snprintf(light, sizeof(light), "[%u,%u,%u,%u]",
+                 s.light.level[LIGHT_LEFT], s.light.level[LIGHT_RIGHT],
+                 s.light.level[LIGHT_UP], s.light.level[LIGHT_DOWN]);
+        snprintf(direction, sizeof(direction), "\"%s\"", sunDirectionName(computeSunError(s.light.level)));
+        snprintf(sky, sizeof(sky), "\"%s\"", skyConditionName(s.light.sky));
+    }
+    if (s.envValid) {
+        formatCenti(temperature, sizeof(temperature), s.env.temperatureCenti);
+        formatCenti(humidity, sizeof(humidity), s.env.humidityCenti);
+    }
+    if (s.rssiValid) {
+        snprintf(rssi, sizeof(rssi), "%d", s.rssi);
+    }
+    if (s.axisValid) {
+        snprintf(axis, sizeof(axis), "{\"azimuth\":%d,\"elevation\":%d}",
+                 s.axis.azimuth, s.axis.elevation);
+    }
+
+    int n = snprintf(buf, len,
+                     "{\"light\":%s,\"dir\":%s,\"sky\":%s,\"temp\":%s,\"hum\":%s,"
+                     "\"uptime\":%u,\"rssi\":%s,\"axis\":%s}",
+                     light, direction, sky, temperature, humidity, s.uptimeSec, rssi, axis);
+
+    return n > 0 && (size_t)n < len ? n : 0;
+}
+
+/**
+ * @brief Serialize the state as CBOR, same keys as the JSON form
+ * @return Length, 0 if it did not fit
+ */
+static inline size_t formatStateCbor(uint8_t* buf, size_t len, const DeviceState& s) {
+    CborWriter w(buf, len);
+
+    w.map(8);
+    w.text("light");
+    if (s.lightValid) {
+        w.array(LIGHT_CHANNELS);
+        for (int i = 0; i < LIGHT_CHANNELS; i++) {
+            w.integer(s.light.level[i]);
+        }
+    } else {
+        w.null();
+    }
+    w.text("dir");
+    s.lightValid ? w.text(sunDirectionName(computeSunError(s.light.level))) : w.null();
+    w.text("sky");
+    s.lightValid ? w.text(skyConditionName(s.light.sky)) : w.null();
+    w.text("temp");
+    s.envValid ? w.number(s.env.temperatureCenti / 100.0f) : w.null();
+    w.text("hum");
+    s.envValid ? w.number(s.env.humidityCenti / 100.0f) : w.null();
+    w.text("uptime");
+    w.integer(s.uptimeSec);
+    w.text("rssi");
+    s.rssiValid ? w.integer(s.rssi) : w.null();
+    w.text("axis");
+    if (s.axisValid) {
+        w.map(2);
+        w.text("azimuth");
+        w.integer(s.axis.azimuth);
+        w.text("elevation");
+        w.integer(s.axis.elevation);
+    } else {
+        w.null();
+    }
+    return w.finish();
+}
+
+/**
+ * @brief Response that owns its serialized body
+ *
+ * The body is encoded once into the inline buffer when the response is
+ * created and copied out as the TCP window allows.
+ */
+class StateResponse : public AsyncAbstractResponse {
+private:
+    uint8_t body[STATE_BODY_MAX];
+    size_t sent = 0;
+
+public:
+    StateResponse(const DeviceState& state, bool cbor) {
+        _code = 200;
+        _contentType = cbor ? STATE_MIME_CBOR : STATE_MIME_JSON;
+        _contentLength = cbor ? formatStateCbor(body, sizeof(body), state)
+                              : formatStateJson(reinterpret_cast<char*>(body), sizeof(body), state);
+        if (_contentLength == 0) {
+            _code = 500;
+        }
+        addHeader("Cache-Control", "no-store");
+        addHeader("Vary", "Accept");
+    }
+
+    bool _sourceValid() const override {
+        return true;
+    }
+
+    size_t _fillBuffer(uint8_t* buf, size_t maxLen) override {
+        size_t n = min(maxLen, _contentLength - sent);
+        memcpy(buf, body + sent, n);
+        sent += n;
+        return n;
+    }
+};
+
+/**
+ * @brief Whether the client asked for CBOR
+ */
+static inline bool wantsCbor(AsyncWebServerRequest* request) {
+    return request->hasHeader("Accept") && request->header("Accept").indexOf(STATE_MIME_CBOR) >= 0;
+}
@@ -0,0 +1,135 @@
+/**
+ * @file StaticAssets.h
+ * @brief Gzipped dashboard files served from LittleFS with HTTP caching
+ * @author Yahya
+ *
+ * The dashboard (web/ in the project) is compressed at build time by
+ * scripts/build_web.py and flashed with "pio run -t uploadfs". Each file
+ * is stored only as <name>.gz and sent as-is with Content-Encoding: gzip,
+ * so the ESP32 never compresses anything at runtime.
+ *
+ * Every asset gets a strong ETag taken from its gzip trailer (CRC32 and
+ * length of the original file), read once at boot. A matching
+ * If-None-Match is answered with 304 and no body. The page itself is
+ * revalidated on every load; scripts and styles are referenced with a
+ * ?v=<crc> suffix and cached for a year, so a reload normally costs one
+ * small 304.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <ESPAsyncWebServer.h>
+
+// Static Asset Configuration
+#define STATIC_CACHE_PAGE       "no-cache"                              // Always revalidate
+#define STATIC_CACHE_VERSIONED  "public, max-age=31536000, immutable"   // URL changes with content
+#define STATIC_ETAG_LEN         20                                      // Quoted 16 hex digits
+
+/**
+ * @brief One file of the dashboard
+ */
+struct StaticAsset {
+    const char* url;
+    const char* contentType;
+    const char* cacheControl;
+    char etag[STATIC_ETAG_LEN];
+    bool available;
+};
+
+class StaticAssets {
+private:
+    StaticAsset assets[4] = {
+        {"/index.html", "text/html", STATIC_CACHE_PAGE, "", false},
+        {"/app.js", "application/javascript", STATIC_CACHE_VERSIONED, "", false},
+        {"/chart.js", "application/javascript", STATIC_CACHE_VERSIONED, "", false},
+        {"/style.css", "text/css", STATIC_CACHE_VERSIONED, "", false},
+    };
+    bool mounted = false;
+
+    /**
+     * @brief Read the ETag of one asset from the last 8 bytes of its .gz file
+     */
+    static bool loadEtag(StaticAsset& asset) {
+        char path[32];
+        snprintf(path, sizeof(path), "%s.gz", asset.url);
+
+        File file = LittleFS.open(path, "r");
+        if (!file || file.size() < 18) {
+            return false;
+        }
+
+        uint8_t trailer[8];
+        file.seek(file.size() - sizeof(trailer));
+        bool ok = file.read(trailer, sizeof(trailer)) == sizeof(trailer);
+        file.close();
+        if (!ok) {
+            return false;
+        }
+
+        uint32_t crc, size;
+        memcpy(&crc, &trailer[0], 4);
+        memcpy(&size, &trailer[4], 4);
+        snprintf(asset.etag, sizeof(asset.etag), "\"%08x%08x\"", crc, size);
+        return true;
+    }
+
+    /**
+     * @brief Answer one request for an asset
+     */
+    static void serve(AsyncWebServerRequest* request, const StaticAsset& asset) {
+        AsyncWebServerResponse* response;
+
+        if (request->hasHeader("If-None-Match") &&
+            request->header("If-None-Match").indexOf(asset.etag) >= 0) {
+            response = request->beginResponse(304);
+        } else {
+            // Only <url>.gz exists; the library sends it with Content-Encoding: gzip
+            response = request->beginResponse(LittleFS, asset.url, asset.contentType);
+        }
+        response->addHeader("ETag", asset.etag);
+        response->addHeader("Cache-Control", asset.cacheControl);
+        request->send(response);
+    }
+
+public:
+    /**
+     * @brief Mount LittleFS and register a route for every asset found
+     *
+     * The filesystem is never formatted here: a missing or empty image only
+     * disables the dashboard, the API keeps working.
+     * @param server Web server to register the routes on
+     * @return true if the dashboard page is available
+     */
+    bool begin(AsyncWebServer& server) {
+        mounted = LittleFS.begin(false);
+        if (!mounted) {
+            Serial.println("WARNING: LittleFS not mounted, run 'pio run -t uploadfs'");
+        }
+
+        for (StaticAsset& asset : assets) {
+            asset.available = mounted && loadEtag(asset);
+            if (!asset.available) {
+                Serial.printf("WARNING: Dashboard file %s.gz missing\n", asset.url);
+                continue;
+            }
+            const StaticAsset* entry = &asset;
+            server.on(asset.url, HTTP_GET, [entry](AsyncWebServerRequest* request) {
+                serve(request, *entry);
+            });
+        }
+        return assets[0].available;
+    }
+
+    /**
+     * @brief Serve the dashboard page, or explain how to install it
+     */
+    void sendIndex(AsyncWebServerRequest* request) const {
+        if (!assets[0].available) {
+            request->send(503, "text/plain", "Dashboard not installed, run 'pio run -t uploadfs'");
+            return;
+        }
+        serve(request, assets[0]);
+    }
+};
@@ -0,0 +1,99 @@
+/**
+ * @file Telemetry.h
+ * @brief Combined telemetry record pushed to dashboard clients
+ * @author Yahya
+ *
+ * Light, sky and environment readings are merged into one small JSON
+ * object per sample and broadcast over Server-Sent Events, so every open
+ * dashboard shares a single push instead of polling several endpoints.
+ * The same record also exists as a packed 24-byte binary frame for the
+ * high-rate WebSocket stream. Formatting writes into caller-provided
+ * buffers; nothing is allocated.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include "HTU.h"
+#include "LightSampler.h"
+#include "Lys.h"
+
+// Telemetry Configuration
+#define TELEMETRY_EVENT_NAME   "telemetry"
+#define TELEMETRY_JSON_MAX     256
+#define TELEMETRY_RETRY_MS     2000    // Browser reconnect delay after a drop
+#define TELEMETRY_FRAME_VERSION 1
+#define TELEMETRY_FLAG_ENV_VALID 0x01
+
+/**
+ * @brief Binary telemetry frame, little-endian, decoded by the dashboard
+ */
+struct __attribute__((packed)) TelemetryFrame {
+    uint8_t version;                    // TELEMETRY_FRAME_VERSION
+    uint8_t direction;                  // SunDirection
+    uint8_t sky;                        // SkyCondition
+    uint8_t flags;                      // TELEMETRY_FLAG_*
+    uint32_t timestampMs;               // Light snapshot time (millis)
+    uint16_t light[LIGHT_CHANNELS];     // Left, Right, Up, Down (12-bit)
+    int16_t temperatureCenti;           // 0.01 degC, valid if TELEMETRY_FLAG_ENV_VALID
+    int16_t humidityCenti;              // 0.01 %RH, valid if TELEMETRY_FLAG_ENV_VALID
+    int16_t azimuth;                    // Q12 error
+    int16_t elevation;                  // Q12 error
+};
+
+static_assert(sizeof(TelemetryFrame) == 24, "Dashboard decoder expects 24-byte frames");
+
+/**
+ * @brief Build one telemetry event body
+ * @param buf Destination buffer
+ * @param len Buffer size
+ * @param light Latest light snapshot
+ * @param env Latest environment snapshot, or nullptr if none yet
+ * @return Length of the JSON text, 0 if it did not fit
+ */
+static inline size_t formatTelemetryJson(char* buf, size_t len, const LightSnapshot& light,
+                                         const EnvSnapshot* env) {
+    SunError error = computeSunError(light.level);
+    char temperature[12] = "null";
+    char humidity[12] = "null";
+
+    if (env && env->valid) {
+        formatCenti(temperature, sizeof(temperature), env->temperatureCenti);
+        formatCenti(humidity, sizeof(humidity), env->humidityCenti);
+    }
+
+    int n = snprintf(buf, len,
+                     "{\"t\":%u,\"temp\":%s,\"hum\":%s,\"light\":[%u,%u,%u,%u],"
+                     "\"az\":%d,\"el\":%d,\"conf\":%u,\"dir\":\"%s\",\"sky\":\"%s\"}",
+                     light.timestampMs, temperature, humidity,
+                     light.level[LIGHT_LEFT], light.level[LIGHT_RIGHT],
+                     light.level[LIGHT_UP], light.level[LIGHT_DOWN],
+                     error.azimuth, error.elevation, error.confidence,
+                     sunDirectionName(error), skyConditionName(light.sky));
+
+    return n > 0 && (size_t)n < len ? n : 0;
+}
+
+/**
+ * @brief Build one binary telemetry frame
+ * @param frame Destination
+ * @param light Latest light snapshot
+ * @param env Latest environment snapshot, or nullptr if none yet
+ */
+static inline void buildTelemetryFrame(TelemetryFrame& frame, const LightSnapshot& light,
+                                       const EnvSnapshot* env) {
+    SunError error = computeSunError(light.level);
+
+    frame.version = TELEMETRY_FRAME_VERSION;
+    frame.direction = sunDirectionCode(error);
+    frame.sky = light.sky;
+    frame.flags = env && env->valid ? TELEMETRY_FLAG_ENV_VALID : 0;
+    frame.timestampMs = light.timestampMs;
+    for (int i = 0; i < LIGHT_CHANNELS; i++) {
+        frame.light[i] = light.level[i];
+    }
+    frame.temperatureCenti = frame.flags ? env->temperatureCenti : 0;
+    frame.humidityCenti = frame.flags ? env->humidityCenti : 0;
+    frame.azimuth = error.azimuth;
+    frame.elevation = error.elevation;
+}
@@ -0,0 +1,278 @@
+/**
+ * @file TrackingConfig.h
+ * @brief Tracking thresholds set from the dashboard, shared lock-free
+ * @author Yahya
+ *
+ * The dashboard's setpoint form maps onto three thresholds:
+ *
+ *   setpoint  deadband in percent of full error: no move command is sent
+ *             while both axes are closer to the sun than this
+ *   minLimit  irradiance (sum of the four channels) below which the sky
+ *             counts as overcast and tracking pauses
+ *   maxLimit  channel level at or above which a sensor is saturated; its
+ *             ratio is meaningless, so tracking holds
+ *
+ * The active set lives in a two-slot SnapshotRing: a writer publishes a
+ * new copy, the sampler and UART tasks pick it up on their next tick
+ * through a TrackingConfigReader, without locks and without a torn read.
+ * Writers (the web handler and the MQTT config topic) go through
+ * TrackingConfigStore, which serializes them with a mutex so the ring
+ * keeps a single producer; update() also reads and merges under it, so
+ * concurrent partial changes cannot undo each other. The set is stored
+ * in NVS as one blob.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <freertos/semphr.h>
+#include "Lys.h"
+#include "SnapshotRing.h"
+
+// Tracking Config Configuration
+#define TRACKING_CFG_NAMESPACE      "tracking"
+#define TRACKING_CFG_KEY            "v1"
+#define TRACKING_CFG_MAGIC          0x5443      // "TC"
+#define TRACKING_DEADBAND_MAX       50          // Percent
+#define TRACKING_SATURATION_OFF     (ADC_MAX_VALUE + 1)
+#define TRACKING_MIN_IRRADIANCE_MAX SKY_DIFFUSE_MAX_IRRADIANCE
+
+/**
+ * @brief One complete set of tracking thresholds
+ */
+struct TrackingConfig {
+    uint16_t deadbandPercent = 0;                   // setpoint
+    uint16_t minIrradiance = SKY_OVERCAST_ENTER;    // minLimit
+    uint16_t saturation = TRACKING_SATURATION_OFF;  // maxLimit, TRACKING_SATURATION_OFF disables
+
+    /**
+     * @brief Check the ranges and that the set leaves room to track
+     * @return nullptr if valid, otherwise the reason
+     */
+    const char* validate() const {
+        if (deadbandPercent > TRACKING_DEADBAND_MAX) {
+            return "setpoint must be 0-50 (%)";
+        }
+        if (minIrradiance <= SKY_NIGHT_EXIT || minIrradiance > TRACKING_MIN_IRRADIANCE_MAX) {
+            return "minLimit must be 201-8000";
+        }
+        if (saturation < 1 || saturation > TRACKING_SATURATION_OFF) {
+            return "maxLimit must be 1-4096 (4096 disables)";
+        }
+        if ((uint32_t)saturation * LIGHT_CHANNELS <= (uint32_t)minIrradiance + SKY_OVERCAST_HYSTERESIS) {
+            return "maxLimit too low for minLimit, tracking could never start";
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Set one field by its dashboard form name
+     * @param name setpoint, maxLimit or minLimit
+     * @param value Decimal text; empty keeps the current value
+     * @return false for an unknown name or a value that is not a number in 0-65535
+     */
+    bool setField(const char* name, const char* value) {
+        uint16_t* field = strcmp(name, "setpoint") == 0 ? &deadbandPercent
+                        : strcmp(name, "maxLimit") == 0 ? &saturation
+                        : strcmp(name, "minLimit") == 0 ? &minIrradiance
+                        : nullptr;
+        if (!field) {
+            return false;
+        }
+        if (value[0] == '\0') {
+            return true;
+        }
+
+        char* end;
+        long parsed = strtol(value, &end, 10);
+        if (*end != '\0' || parsed < 0 || parsed > UINT16_MAX) {
+            return false;
+        }
+        *field = parsed;
+        return true;
+    }
+
+    /**
+     * @brief Apply "name=value&name=value" text, as posted by the form
+     * @param text Fields, modified in place
+     * @return false if any field was rejected by setField()
+     */
+    bool setFields(char* text) {
+        char* save;
+        for (char* pair = strtok_r(text, "&", &save); pair; pair = strtok_r(nullptr, "&", &save)) {
+            char* value = strchr(pair, '=');
+            if (!value) {
+                return false;
+            }
+            *value++ = '\0';
+            if (!setField(pair, value)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Whether any channel is at or above the saturation level
+     */
+    bool saturated(const uint16_t level[LIGHT_CHANNELS]) const {
+        for (int i = 0; i < LIGHT_CHANNELS; i++) {
+            if (level[i] >= saturation) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Whether both axes are inside the deadband
+     */
+    bool withinDeadband(const SunError& e) const {
+        int32_t limit = ((int32_t)deadbandPercent << SUN_ERROR_SHIFT) / 100;
+        int32_t az = e.azimuth < 0 ? -e.azimuth : e.azimuth;
+        int32_t el = e.elevation < 0 ? -e.elevation : e.elevation;
+        return az < limit && el < limit;
+    }
+};
+
+// Published thresholds; written only through TrackingConfigStore
+SnapshotRing<TrackingConfig, 2> trackingConfig;
+
+/**
+ * @brief Per-task copy of the thresholds, refreshed when a new set is published
+ */
+class TrackingConfigReader {
+private:
+    TrackingConfig value;
+    uint32_t seen = 0;
+
+public:
+    const TrackingConfig& get() {
+        uint32_t published = trackingConfig.published();
+        if (published != seen && trackingConfig.latest(value)) {
+            seen = published;
+        }
+        return value;
+    }
+};
+
+class TrackingConfigStore {
+private:
+    struct Record {
+        uint16_t magic;
+        uint16_t size;
+        TrackingConfig config;
+    };
+
+    StaticSemaphore_t writerBuffer;
+    SemaphoreHandle_t writer;
+
+    /**
+     * @brief Validate, publish and store a set (writer mutex held)
+     */
+    const char* commit(const TrackingConfig& config, bool store) {
+        const char* error = config.validate();
+        if (error) {
+            return error;
+        }
+        trackingConfig.push(config);
+        if (store && !save(config)) {
+            Serial.println("ERROR: Failed to store tracking config");
+        }
+        return nullptr;
+    }
+
+public:
+    TrackingConfigStore() {
+        writer = xSemaphoreCreateMutexStatic(&writerBuffer);
+    }
+
+    /**
+     * @brief Validate, publish to the running tasks and store a new set
+     *
+     * Safe from any task. Readers never wait for this.
+     * @param config New thresholds
+     * @param store false to only publish (e.g. a set just loaded from NVS)
+     * @return nullptr on success, otherwise why the set was rejected
+     */
+    const char* apply(const TrackingConfig& config, bool store = true) {
+        xSemaphoreTake(writer, portMAX_DELAY);
+        const char* error = commit(config, store);
+        xSemaphoreGive(writer);
+        return error;
+    }
+
+    /**
+     * @brief Change some fields of the active set, then apply it
+     *
+     * Safe from any task. The active set is read, edited, validated,
+     * published and stored under one lock, so a concurrent update of
+     * other fields is never lost.
+     * @param edit Callable taking a TrackingConfig& to change in place and
+     *             returning nullptr, or a reason to abandon the update
+     * @param result Receives the set now active, if not null
+     * @return nullptr on success, otherwise why nothing changed
+     */
+    template <typename Edit>
+    const char* update(Edit edit, TrackingConfig* result = nullptr) {
+        TrackingConfig config;
+
+        xSemaphoreTake(writer, portMAX_DELAY);
+        trackingConfig.latest(config);
+        const char* error = edit(config);
+        if (!error) {
+            error = commit(config, true);
+        }
+        if (result) {
+            trackingConfig.latest(*result);
+        }
+        xSemaphoreGive(writer);
+        return error;
+    }
+
+    /**
+     * @brief Load the stored thresholds
+     * @param out Receives the stored set, or the defaults if none is valid
+     * @return true if a valid record was found
+     */
+    bool load(TrackingConfig& out) {
+        Preferences prefs;
+        Record record;
+
+        out = TrackingConfig();
+        if (!prefs.begin(TRACKING_CFG_NAMESPACE, true)) {
+            return false;
+        }
+        size_t len = prefs.getBytes(TRACKING_CFG_KEY, &record, sizeof(record));
+        prefs.end();
+
+        if (len != sizeof(record) || record.magic != TRACKING_CFG_MAGIC ||
+            record.size != sizeof(TrackingConfig) || record.config.validate()) {
+            Serial.println("Tracking config: none stored, using defaults");
+            return false;
+        }
+
+        out = record.config;
+        Serial.printf("Tracking config: deadband %u%%, min irradiance %u, saturation %u\n",
+                      out.deadbandPercent, out.minIrradiance, out.saturation);
+        return true;
+    }
+
+    /**
+     * @brief Persist a set of thresholds
+     * @param config Validated thresholds
+     * @return true on success
+     */
+    bool save(const TrackingConfig& config) {
+        Preferences prefs;
+        Record record = {TRACKING_CFG_MAGIC, sizeof(TrackingConfig), config};
+
+        if (!prefs.begin(TRACKING_CFG_NAMESPACE, false)) {
+            return false;
+        }
+        bool ok = prefs.putBytes(TRACKING_CFG_KEY, &record, sizeof(record)) == sizeof(record);
+        prefs.end();
+        return ok;
+    }
+};
@@ -0,0 +1,254 @@
+/**
+ * @file WebAdmission.h
+ * @brief Admission control for the web server: connection and rate limits
+ * @author Yahya
+ *
+ * Every request is put in a class before its handler runs:
+ *
+ *   control  setpoint, state, calibration: small, must get through
+ *   normal   everything not listed
+ *   bulk     history and selftest streams: large, can wait
+ *   stream   WebSocket and SSE upgrades
+ *
+ * and turned away when serving it would cost the sensing side:
+ *
+ *   - more than WEB_MAX_CONNECTIONS open HTTP requests; the last
+ *     WEB_CONTROL_RESERVE of them are kept for control requests
+ *   - more than WEB_MAX_BULK bulk transfers at once
+ *   - free heap below WEB_MIN_FREE_HEAP (control requests still pass)
+ *   - WebSocket or SSE clients beyond their limit
+ *   - a client over its request rate: a token bucket per address, refilled
+ *     at WEB_RATE_PER_SEC up to WEB_RATE_BURST, bulk requests cost
+ *     WEB_BULK_COST tokens
+ *
+ * Overload is answered with 503, a client over its rate with 429, both
+ * with Retry-After and a few bytes of body, so a busy server costs the
+ * client a retry instead of the ESP32 its heap.
+ *
+ * The checks run inside WebMetrics, which owns the connection lifecycle;
+ * both live on the AsyncTCP task, so no locking is needed.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <esp_heap_caps.h>
+
+// Web Admission Configuration (override with build_flags)
+#ifndef WEB_MAX_CONNECTIONS
+#define WEB_MAX_CONNECTIONS     8       // Open HTTP requests, all classes
+#endif
+#ifndef WEB_CONTROL_RESERVE
+#define WEB_CONTROL_RESERVE     2       // Of those, only for control requests
+#endif
+#ifndef WEB_MAX_BULK
+#define WEB_MAX_BULK            2       // Bulk transfers at once
+#endif
+#ifndef WEB_MAX_WS_CLIENTS
+#define WEB_MAX_WS_CLIENTS      3
+#endif
+#ifndef WEB_MAX_SSE_CLIENTS
+#define WEB_MAX_SSE_CLIENTS     3
+#endif
+#ifndef WEB_MIN_FREE_HEAP
+#define WEB_MIN_FREE_HEAP       32768   // bytes; below this only control requests are served
+#endif
+#ifndef WEB_RATE_PER_SEC
+#define WEB_RATE_PER_SEC        5       // Tokens per second per client
+#endif
+#ifndef WEB_RATE_BURST
+#define WEB_RATE_BURST          20      // Bucket size, covers a dashboard page load
+#endif
+#define WEB_BULK_COST           2       // Tokens per bulk request, 1 for the rest
+#define WEB_RATE_CLIENTS        8       // Clients tracked; the longest idle is replaced
+#define WEB_RETRY_AFTER_S       2       // Retry-After for overload
+
+enum WebClass : uint8_t {
+    WEB_CLASS_CONTROL,
+    WEB_CLASS_NORMAL,
+    WEB_CLASS_BULK,
+    WEB_CLASS_STREAM
+};
+
+enum WebReject : uint8_t {
+    WEB_REJECT_NONE,
+    WEB_REJECT_CONNECTIONS,
+    WEB_REJECT_BULK,
+    WEB_REJECT_HEAP,
+    WEB_REJECT_STREAMS,
+    WEB_REJECT_RATE,
+    WEB_REJECT_COUNT
+};
+
+/**
+ * @brief Class of a request that is not a WebSocket or SSE upgrade
+ */
+typedef WebClass (*WebClassifier)(AsyncWebServerRequest* request);
+
+class WebAdmission {
+private:
+    struct Client {
+        uint32_t address;               // 0 marks a free slot
+        uint32_t lastMs;
+        int32_t milliTokens;
+    };
+
+    WebClassifier classifier = nullptr;
+    AsyncWebSocket* ws = nullptr;
+    AsyncEventSource* events = nullptr;
+
+    Client clients[WEB_RATE_CLIENTS] = {};
+    uint16_t bulkOpen = 0;
+    uint32_t retryAfter = WEB_RETRY_AFTER_S;
+    uint32_t rejected[WEB_REJECT_COUNT] = {};
+
+    /**
+     * @brief Take tokens from a client's bucket
+     * @return false if the bucket is short; retryAfter is set to the wait
+     */
+    bool take(uint32_t address, int32_t tokens, uint32_t nowMs) {
+        const int32_t burst = WEB_RATE_BURST * 1000;
+        Client* client = nullptr;
+        Client* idlest = &clients[0];
+
+        for (Client& c : clients) {
+            if (c.address == address) {
+                client = &c;
+                break;
+            }
+            if (c.address == 0 || (idlest->address != 0 && nowMs - c.lastMs > nowMs - idlest->lastMs)) {
+                idlest = &c;
+            }
+        }
+        if (!client) {
+            client = idlest;
+            *client = {address, nowMs, burst};
+        }
+
+        uint32_t elapsed = nowMs - client->lastMs;
+        client->lastMs = nowMs;
+        client->milliTokens = min((int64_t)burst, client->milliTokens + (int64_t)elapsed * WEB_RATE_PER_SEC);
+
+        int32_t cost = tokens * 1000;
+        if (client->milliTokens < cost) {
+            int32_t waitMs = (cost - client->milliTokens) / WEB_RATE_PER_SEC;
+            retryAfter = waitMs / 1000 + 1;
+            return false;
+        }
+        client->milliTokens -= cost;
+        return true;
+    }
+
+public:
+    /**
+     * @brief Set how requests are classed and which stream handlers to cap
+     */
+    void begin(WebClassifier classify, AsyncWebSocket& socket, AsyncEventSource& source) {
+        classifier = classify;
+        ws = &socket;
+        events = &source;
+    }
+
+    /**
+     * @brief Class of a request
+     * @param upgrade WebSocket or SSE request
+     */
+    WebClass classify(AsyncWebServerRequest* request, bool upgrade) const {
+        if (upgrade) {
+            return WEB_CLASS_STREAM;
+        }
+        return classifier ? classifier(request) : WEB_CLASS_NORMAL;
+    }
+
+    /**
+     * @brief Decide whether a request may run
+     * @param request The request
+     * @param cls Its class from classify()
+     * @param open HTTP requests already open, not counting this one
+     * @return WEB_REJECT_NONE to run it, otherwise why not; an admitted bulk
+     *         request holds a slot until release()
+     */
+    WebReject admit(AsyncWebServerRequest* request, WebClass cls, uint16_t open) {
+        WebReject reason = WEB_REJECT_NONE;
+        retryAfter = WEB_RETRY_AFTER_S;
+
+        if (open >= WEB_MAX_CONNECTIONS ||
+            (cls != WEB_CLASS_CONTROL && open >= WEB_MAX_CONNECTIONS - WEB_CONTROL_RESERVE)) {
+            reason = WEB_REJECT_CONNECTIONS;
+        } else if (cls == WEB_CLASS_BULK && bulkOpen >= WEB_MAX_BULK) {
+            reason = WEB_REJECT_BULK;
+        } else if (cls != WEB_CLASS_CONTROL && heap_caps_get_free_size(MALLOC_CAP_8BIT) < WEB_MIN_FREE_HEAP) {
+            reason = WEB_REJECT_HEAP;
+        } else if (cls == WEB_CLASS_STREAM &&
+                   (request->hasHeader("Upgrade") ? ws && ws->count() >= WEB_MAX_WS_CLIENTS
+                                                  : events && events->count() >= WEB_MAX_SSE_CLIENTS)) {
+            reason = WEB_REJECT_STREAMS;
+        } else if (!take((uint32_t)request->client()->remoteIP(), cls == WEB_CLASS_BULK ? WEB_BULK_COST : 1,
+                         millis())) {
+            reason = WEB_REJECT_RATE;
+        }
+
+        if (reason != WEB_REJECT_NONE) {
+            rejected[reason]++;
+        } else if (cls == WEB_CLASS_BULK) {
+            bulkOpen++;
+        }
+        return reason;
+    }
+
+    /**
+     * @brief An admitted request of this class has finished
+     */
+    void release(WebClass cls) {
+        if (cls == WEB_CLASS_BULK && bulkOpen > 0) {
+            bulkOpen--;
+        }
+    }
+
+    /**
+     * @brief Answer a request admit() turned away
+     */
+    void reject(AsyncWebServerRequest* request, WebReject reason) const {
+        char seconds[8];
+        snprintf(seconds, sizeof(seconds), "%u", retryAfter);
+
+        AsyncWebServerResponse* response = reason == WEB_REJECT_RATE
+            ? request->beginResponse(429, "text/plain", "Too many requests")
+            : request->beginResponse(503, "text/plain", "Busy");
+        response->addHeader("Retry-After", seconds);
+        response->addHeader("Cache-Control", "no-store");
+        request->send(response);
+    }
+
+    uint32_t rejections(WebReject reason) const {
+        return rejected[reason];
+    }
+
+    static const char* reasonName(WebReject reason) {
+        static const char* const names[WEB_REJECT_COUNT] = {
+            "none", "connections", "bulk", "heap", "streams", "rate"
+        };
+        return names[reason];
+    }
+};
+
+/**
+ * @brief Admission class of a firmware route, the WebClassifier main.cpp uses
+ *
+ * Setpoint, state and calibration must get through while dashboards load;
+ * history and the selftest streams are the first to wait. Dashboard files
+ * stay normal: a page load fetches several of them at once, and they are
+ * small and mostly answered with 304.
+ */
+inline WebClass classifyRequest(AsyncWebServerRequest* request) {
+    const String& url = request->url();
+
+    if (url == "/setpoint" || url == "/api/state" || url.startsWith("/calibrate/")) {
+        return WEB_CLASS_CONTROL;
+    }
+    if (url == "/history" || url.startsWith("/selftest/")) {
+        return WEB_CLASS_BULK;
+    }
+    return WEB_CLASS_NORMAL;
+}
@@ -0,0 +1,355 @@
+/**
+ * @file WebMetrics.h
+ * @brief Per-route web server instrumentation and Prometheus /metrics
+ * @author Yahya
+ *
+ * Installed as a server-wide middleware, so every route is measured,
+ * including the ones registered by StaticAssets:
+ *
+ *   - requests and 4xx/5xx responses per route
+ *   - handler time (esp_timer_get_time) as total and maximum
+ *   - bytes written to the client, counted once the connection closes
+ *   - free heap before minus after the handler, i.e. what the handler and
+ *     its response object took (other tasks allocating at the same moment
+ *     show up here too)
+ *   - open HTTP connections, current and peak
+ *
+ * Routes are added to a fixed table the first time they answer; 404s,
+ * rejected requests to unknown paths and anything past WEB_METRICS_ROUTES
+ * share the "other" row, so scanners cannot grow it. WebSocket and SSE
+ * upgrades are counted as requests but not as open connections; they
+ * live on in their own handlers.
+ *
+ * With a WebAdmission attached, each request is checked before its
+ * handler runs and answered with 503/429 instead when it is turned away.
+ *
+ * The middleware, the disconnect callbacks and the /metrics renderer all
+ * run on the AsyncTCP task, so the counters need no locking. /metrics is
+ * produced row by row into the response's chunk buffer.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include "WebAdmission.h"
+
+// Web Metrics Configuration
+#define WEB_METRICS_ROUTES      24
+#define WEB_METRICS_ROUTE_LEN   32
+#define WEB_METRICS_TASKS       10
+#define WEB_METRICS_LINE_MAX    192
+
+/**
+ * @brief Read-only access to response bookkeeping the library keeps protected
+ */
+struct ResponseStats : AsyncWebServerResponse {
+    static int code(const AsyncWebServerResponse* r) {
+        return r->*(&ResponseStats::_code);
+    }
+    static size_t written(const AsyncWebServerResponse* r) {
+        return r->*(&ResponseStats::_writtenLength);
+    }
+};
+
+class WebMetrics : public AsyncMiddleware {
+public:
+    /**
+     * @brief Position of one /metrics transfer; start from a zeroed cursor
+     */
+    struct Cursor {
+        uint16_t family = 0;
+        uint16_t row = 0;
+        uint16_t lineLen = 0;
+        uint16_t lineSent = 0;
+        char line[WEB_METRICS_LINE_MAX];
+    };
+
+private:
+    struct Route {
+        char path[WEB_METRICS_ROUTE_LEN];
+        uint32_t requests;
+        uint32_t errors;                // 4xx and 5xx
+        uint64_t handlerUs;
+        uint32_t handlerMaxUs;
+        uint64_t bytes;
+        int64_t heapDelta;
+    };
+
+    enum Family {
+        FAM_REQUESTS,
+        FAM_ERRORS,
+        FAM_HANDLER_SECONDS,
+        FAM_HANDLER_MAX,
+        FAM_BYTES,
+        FAM_HEAP_DELTA,
+        FAM_CONNECTIONS,
+        FAM_CONNECTIONS_MAX,
+        FAM_HEAP_FREE,
+        FAM_HEAP_MIN_FREE,
+        FAM_HEAP_LARGEST,
+        FAM_STACK,
+        FAM_REJECTED,
+        FAM_COUNT
+    };
+
+    Route routes[WEB_METRICS_ROUTES + 1];   // Last row is "other"
+    uint8_t routeCount = 0;
+    uint16_t connections = 0;
+    uint16_t connectionsMax = 0;
+    const char* tasks[WEB_METRICS_TASKS];
+    uint8_t taskCount = 0;
+    WebAdmission* admission = nullptr;
+
+    Route& other() {
+        return routes[WEB_METRICS_ROUTES];
+    }
+
+    /**
+     * @brief Row for a path
+     * @param create Add the path if it has no row yet
+     */
+    Route& route(const String& path, bool create) {
+        for (uint8_t i = 0; i < routeCount; i++) {
+            if (path.equals(routes[i].path)) {
+                return routes[i];
+            }
+        }
+        if (!create || routeCount == WEB_METRICS_ROUTES || path.length() >= WEB_METRICS_ROUTE_LEN) {
+            return other();
+        }
+        Route& r = routes[routeCount++];
+        memset(&r, 0, sizeof(r));
+        strcpy(r.path, path.c_str());
+        return r;
+    }
+
+    static bool isUpgrade(AsyncWebServerRequest* request) {
+        return request->hasHeader("Upgrade") ||
+               (request->hasHeader("Accept") && request->header("Accept").indexOf("text/event-stream") >= 0);
+    }
+
+    /**
+     * @brief Rows of one family
+     */
+    uint16_t rows(uint16_t family) const {
+        switch (family) {
+        case FAM_REQUESTS:
+        case FAM_ERRORS:
+        case FAM_HANDLER_SECONDS:
+        case FAM_HANDLER_MAX:
+        case FAM_BYTES:
+        case FAM_HEAP_DELTA:
+            return routeCount + 1;
+        case FAM_STACK:
+            return taskCount;
+        case FAM_REJECTED:
+            return admission ? WEB_REJECT_COUNT - 1 : 0;
+        default:
+            return 1;
+        }
+    }
+
+    /**
+     * @brief HELP and TYPE lines of a family
+     */
+    static int header(uint16_t family, char* buf, size_t len) {
+        static const char* const families[FAM_COUNT][3] = {
+            {"esp32_http_requests_total", "counter", "HTTP requests per route"},
+            {"esp32_http_errors_total", "counter", "HTTP 4xx/5xx responses per route"},
+            {"esp32_http_handler_seconds_total", "counter", "Time spent in route handlers"},
+            {"esp32_http_handler_seconds_max", "gauge", "Slowest handler call per route"},
+            {"esp32_http_response_bytes_total", "counter", "Bytes written to clients per route"},
+            {"esp32_http_handler_heap_bytes", "gauge", "Free heap taken by handlers in total (negative: released)"},
+            {"esp32_http_connections", "gauge", "Open HTTP connections"},
+            {"esp32_http_connections_max", "gauge", "Most HTTP connections open at once"},
+            {"esp32_heap_free_bytes", "gauge", "Free heap"},
+            {"esp32_heap_min_free_bytes", "gauge", "Lowest free heap since boot"},
+            {"esp32_heap_largest_free_block_bytes", "gauge", "Largest allocatable heap block"},
+            {"esp32_task_stack_high_water_bytes", "gauge", "Unused stack at the deepest point per task"},
+            {"esp32_http_rejected_total", "counter", "Requests turned away by admission control"},
+        };
+        const char* const* f = families[family];
+        return snprintf(buf, len, "# HELP %s %s\n# TYPE %s %s\n", f[0], f[2], f[0], f[1]);
+    }
+
+    /**
+     * @brief One sample line; 0 if the row has nothing to report
+     */
+    int sample(uint16_t family, uint16_t row, char* buf, size_t len) const {
+        if (family <= FAM_HEAP_DELTA) {
+            const Route& r = row < routeCount ? routes[row] : routes[WEB_METRICS_ROUTES];
+            const char* path = row < routeCount ? r.path : "other";
+            switch (family) {
+            case FAM_REQUESTS:
+                return snprintf(buf, len, "esp32_http_requests_total{route=\"%s\"} %u\n", path, r.requests);
+            case FAM_ERRORS:
+                return snprintf(buf, len, "esp32_http_errors_total{route=\"%s\"} %u\n", path, r.errors);
+            case FAM_HANDLER_SECONDS:
+                return snprintf(buf, len, "esp32_http_handler_seconds_total{route=\"%s\"} %.6f\n",
+                                path, r.handlerUs / 1e6);
+            case FAM_HANDLER_MAX:
+                return snprintf(buf, len, "esp32_http_handler_seconds_max{route=\"%s\"} %.6f\n",
+                                path, r.handlerMaxUs / 1e6);
+            case FAM_BYTES:
+                return snprintf(buf, len, "esp32_http_response_bytes_total{route=\"%s\"} %llu\n",
+                                path, (unsigned long long)r.bytes);
+            default:
+                return snprintf(buf, len, "esp32_http_handler_heap_bytes{route=\"%s\"} %lld\n",
+                                path, (long long)r.heapDelta);
+            }
+        }
+
+        switch (family) {
+        case FAM_CONNECTIONS:
+            return snprintf(buf, len, "esp32_http_connections %u\n", connections);
+        case FAM_CONNECTIONS_MAX:
+            return snprintf(buf, len, "esp32_http_connections_max %u\n", connectionsMax);
+        case FAM_HEAP_FREE:
+            return snprintf(buf, len, "esp32_heap_free_bytes %u\n",
+                            (unsigned)heap_caps_get_free_size(MALLOC_CAP_8BIT));
+        case FAM_HEAP_MIN_FREE:
+            return snprintf(buf, len, "esp32_heap_min_free_bytes %u\n",
+                            (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+        case FAM_HEAP_LARGEST:
+            return snprintf(buf, len, "esp32_heap_largest_free_block_bytes %u\n",
+                            (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+        case FAM_REJECTED: {
+            WebReject reason = (WebReject)(row + 1);
+            return snprintf(buf, len, "esp32_http_rejected_total{reason=\"%s\"} %u\n",
+                            WebAdmission::reasonName(reason), admission->rejections(reason));
+        }
+        default: {
+            TaskHandle_t task = xTaskGetHandle(tasks[row]);
+            if (!task) {
+                return 0;
+            }
+            return snprintf(buf, len, "esp32_task_stack_high_water_bytes{task=\"%s\"} %u\n",
+                            tasks[row], uxTaskGetStackHighWaterMark(task));
+        }
+        }
+    }
+
+public:
+    WebMetrics() {
+        memset(routes, 0, sizeof(routes));
+        strcpy(other().path, "other");
+    }
+
+    /**
+     * @brief Report the stack high-water mark of a task by name
+     * @param name FreeRTOS task name (string must stay valid)
+     */
+    void watchTask(const char* name) {
+        if (taskCount < WEB_METRICS_TASKS) {
+            tasks[taskCount++] = name;
+        }
+    }
+
+    /**
+     * @brief Check requests against an admission policy before they run
+     */
+    void setAdmission(WebAdmission& policy) {
+        admission = &policy;
+    }
+
+    /**
+     * @brief Middleware entry: admit, measure the handler, then the finished response
+     */
+    void run(AsyncWebServerRequest* request, ArMiddlewareNext next) override {
+        bool upgrade = isUpgrade(request);
+        WebClass cls = admission ? admission->classify(request, upgrade) : WEB_CLASS_NORMAL;
+        WebReject reason = admission ? admission->admit(request, cls, connections) : WEB_REJECT_NONE;
+        bool admitted = reason == WEB_REJECT_NONE;
+        bool stream = upgrade && admitted;      // A refused upgrade is a plain response
+        size_t heapBefore = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        int64_t start = esp_timer_get_time();
+
+        if (!stream) {
+            connections++;
+            connectionsMax = max(connectionsMax, connections);
+        }
+
+        if (admitted) {
+            next();
+        } else {
+            admission->reject(request, reason);
+        }
+
+        uint32_t elapsed = esp_timer_get_time() - start;
+        AsyncWebServerResponse* response = request->getResponse();
+        int code = response ? ResponseStats::code(response) : 0;
+        Route& r = route(request->url(), admitted && code != 404);
+
+        r.requests++;
+        if (code >= 400) {
+            r.errors++;
+        }
+        r.handlerUs += elapsed;
+        r.handlerMaxUs = max(r.handlerMaxUs, elapsed);
+        r.heapDelta += (int64_t)heapBefore - (int64_t)heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+        if (stream) {
+            return;
+        }
+        Route* row = &r;
+        request->onDisconnect([this, request, row, cls, admitted]() {
+            AsyncWebServerResponse* sent = request->getResponse();
+            if (sent) {
+                row->bytes += ResponseStats::written(sent);
+            }
+            connections--;
+            if (admitted && admission) {
+                admission->release(cls);
+            }
+        });
+    }
+
+    /**
+     * @brief Open HTTP connections (AsyncTCP task)
+     */
+    uint16_t openConnections() const {
+        return connections;
+    }
+
+    /**
+     * @brief Render the next part of the Prometheus text
+     * @param c Transfer position, advanced past what was written
+     * @param out Destination
+     * @param len Space in out
+     * @return Bytes written, 0 once everything has been sent
+     */
+    size_t render(Cursor& c, uint8_t* out, size_t len) const {
+        size_t written = 0;
+
+        while (written < len) {
+            if (c.lineSent < c.lineLen) {
+                size_t n = min(len - written, (size_t)(c.lineLen - c.lineSent));
+                memcpy(out + written, c.line + c.lineSent, n);
+                c.lineSent += n;
+                written += n;
+                continue;
+            }
+            if (c.family >= FAM_COUNT) {
+                break;
+            }
+
+            int n;
+            if (c.row == 0) {
+                n = header(c.family, c.line, sizeof(c.line));
+            } else {
+                n = sample(c.family, c.row - 1, c.line, sizeof(c.line));
+            }
+            c.lineLen = n > 0 ? min(n, (int)sizeof(c.line) - 1) : 0;
+            c.lineSent = 0;
+
+            if (++c.row > rows(c.family)) {
+                c.family++;
+                c.row = 0;
+            }
+        }
+        return written;
+    }
+};
@@ -0,0 +1,56 @@
+"""
+PlatformIO pre-build script: compress the dashboard into the LittleFS image.
+
+Every file in web/ is written to data/<name>.gz (gzip level 9, no name or
+timestamp in the header, so identical sources give identical images).
+References to the other assets in index.html get a ?v=<crc> suffix, which
+lets the ESP32 serve scripts and styles with an immutable cache lifetime:
+a changed file gets a new URL instead of a stale cached copy.
+
+Upload the result with: pio run -t uploadfs
+"""
+
+import gzip
+import os
+import zlib
+
+Import("env")  # noqa: F821 (provided by PlatformIO)
+
+PROJECT_DIR = env.subst("$PROJECT_DIR")  # noqa: F821
+WEB_DIR = os.path.join(PROJECT_DIR, "web")
+DATA_DIR = env.subst("$PROJECT_DATA_DIR")  # noqa: F821
+ENTRY = "index.html"
+
+
+def read(name):
+    with open(os.path.join(WEB_DIR, name), "rb") as f:
+        return f.read()
+
+
+def write_gzip(name, content):
+    path = os.path.join(DATA_DIR, name + ".gz")
+    with open(path, "wb") as raw:
+        with gzip.GzipFile(filename="", mode="wb", fileobj=raw, compresslevel=9, mtime=0) as gz:
+            gz.write(content)
+    return os.path.getsize(path)
+
+
+def build():
+    os.makedirs(DATA_DIR, exist_ok=True)
+    names = sorted(n for n in os.listdir(WEB_DIR) if os.path.isfile(os.path.join(WEB_DIR, n)))
+    entry = read(ENTRY).decode("utf-8")
+
+    for name in names:
+        if name == ENTRY:
+            continue
+        content = read(name)
+        version = "%08x" % (zlib.crc32(content) & 0xFFFFFFFF)
+        entry = entry.replace('"/%s"' % name, '"/%s?v=%s"' % (name, version))
+        size = write_gzip(name, content)
+        print("web: %-12s %6d -> %6d bytes" % (name, len(content), size))
+
+    size = write_gzip(ENTRY, entry.encode("utf-8"))
+    print("web: %-12s %6d -> %6d bytes" % (ENTRY, len(entry), size))
+
+
+build()
@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+"""
+Stream selftest: pull large chunked responses from the ESP32 and check the
+heap it reports afterwards.
+
+Needs firmware built with -D ENABLE_STREAM_SELFTEST. Each client downloads
+/selftest/stream?kb=N (consecutive little-endian 32-bit counters) and the
+body is verified byte for byte. Afterwards /selftest/stream/result gives
+the lowest free heap the device saw while sending.
+
+    python3 scripts/stream_selftest.py 192.168.1.50 --kb 512 --clients 3
+
+The web server runs at most WEB_MAX_BULK (2) selftest streams at once and
+answers the rest with 503 and Retry-After; those clients wait as told and
+try again, so with more clients than that the downloads overlap in part.
+"""
+
+import argparse
+import json
+import struct
+import sys
+import threading
+import time
+import urllib.error
+import urllib.request
+
+RETRIES = 20            # Attempts per request while the device answers 503/429
+
+
+def expected(kb):
+    return b"".join(struct.pack("<I", i) for i in range(kb * 1024 // 4))
+
+
+def fetch(url, timeout):
+    """GET a URL, waiting out 503 (busy) and 429 (rate) answers as the device asks."""
+    for attempt in range(RETRIES):
+        try:
+            with urllib.request.urlopen(url, timeout=timeout) as response:
+                return response.read()
+        except urllib.error.HTTPError as e:
+            if e.code not in (429, 503) or attempt == RETRIES - 1:
+                raise
+            time.sleep(float(e.headers.get("Retry-After", 1)))
+
+
+def download(url, out, index):
+    try:
+        out[index] = fetch(url, 60)
+    except OSError as e:
+        out[index] = e
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("host", help="ESP32 address")
+    parser.add_argument("--kb", type=int, default=512, help="payload per client (default 512)")
+    parser.add_argument("--clients", type=int, default=1, help="parallel downloads (default 1)")
+    parser.add_argument("--min-heap", type=int, default=20000,
+                        help="fail if free heap dropped below this many bytes (default 20000)")
+    args = parser.parse_args()
+
+    base = "http://%s" % args.host
+    bodies = [None] * args.clients
+    threads = [threading.Thread(target=download, args=("%s/selftest/stream?kb=%d" % (base, args.kb), bodies, i))
+               for i in range(args.clients)]
+
+    start = time.monotonic()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    elapsed = time.monotonic() - start
+
+    ok = True
+    reference = expected(args.kb)
+    for i, body in enumerate(bodies):
+        if isinstance(body, Exception):
+            print("client %d: %s" % (i, body))
+            ok = False
+        elif body != reference:
+            print("client %d: %d bytes, payload mismatch" % (i, len(body)))
+            ok = False
+
+    total = args.kb * 1024 * args.clients
+    print("%d bytes in %.1f s (%.0f KB/s)" % (total, elapsed, total / 1024 / elapsed))
+
+    result = json.loads(fetch(base + "/selftest/stream/result", 10))
+    print("free heap: %(heapBefore)d before, %(heapMin)d lowest during the last run, "
+          "%(lowestHeap)d lowest in any run, %(minFreeSinceBoot)d since boot; "
+          "smallest largest block %(largestMin)d" % result)
+
+    if result["lowestHeap"] < args.min_heap:
+        print("free heap fell below %d" % args.min_heap)
+        ok = False
+
+    print("PASS" if ok else "FAIL")
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
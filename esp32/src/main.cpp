@@ -10,11 +10,24 @@
 #include <Arduino.h>
 #include <Wire.h>
 #include <esp_task_wdt.h>
-#include <esp_adc_cal.h>
+#include <esp_timer.h>
+#include "AdcCalibration.h"
+#include "AxisLink.h"
+#include "ChunkedStream.h"
 #include "DisplayHandler.h"
-#include "Endpoints.h"
 #include "HTU.h"
 #include "Lys.h"
+#include "LightSampler.h"
+#include "LightCalibrationStore.h"
+#include "MqttPublisher.h"
+#include "PowerManager.h"
+#include "Telemetry.h"
+#include "TrackingConfig.h"
+#include "HistoryStore.h"
+#include "StateApi.h"
+#include "StaticAssets.h"
+#include "WebAdmission.h"
+#include "WebMetrics.h"
 #include "Wifi_Config.h"
 
 // I2C Configuration
@@ -41,39 +54,415 @@ const char* WIFI_PASSWORD = "";
 
 // Task Configuration
 #define SENSOR_READ_INTERVAL 1000  // milliseconds
-#define LIGHT_READ_INTERVAL  1000  // milliseconds
+#define DISPLAY_INTERVAL     1000  // milliseconds
+#define UART_SEND_INTERVAL   50    // milliseconds
+#define UART_IDLE_INTERVAL   1000  // milliseconds, while the sky is not trackable
+#define UART_TASK_PRIO       1
+#define TELEMETRY_INTERVAL   250   // milliseconds, poll for a new environment sample
+#define WS_STREAM_INTERVAL   100   // milliseconds, binary telemetry frame rate (10 Hz)
+#define WS_CLEANUP_INTERVAL  1000  // milliseconds
 
 // Global Objects
-HTU21D humidity_temperature;
 DisplayHandler display;
 HardwareSerial RP(1);  // UART1 for Raspberry Pi communication
 LightSensor leftSensor(LIGHT_LEFT_PIN);
 LightSensor rightSensor(LIGHT_RIGHT_PIN);
 LightSensor upSensor(LIGHT_UP_PIN);
 LightSensor downSensor(LIGHT_DOWN_PIN);
+AdcCalibration adcCalibration;
+LightSampler lightSampler;
+LightCalibrationStore lightCalibrationStore;
+TrackingConfigStore trackingConfigStore;
+PowerManager powerManager;
+HistoryStore history;
+StaticAssets staticAssets;
+AxisLink axisLink;
+MqttPublisher mqtt;
+WebAdmission admission;
+WebMetrics webMetrics;
+#ifdef ENABLE_STREAM_SELFTEST
+StreamSelftest streamSelftest;
+#endif
 AsyncWebServer server(WEB_SERVER_PORT);
+AsyncEventSource events("/events");
+AsyncWebSocket ws("/ws");
 
 /**
- * @brief Web server root handler
+ * @brief Web server root handler (dashboard page from LittleFS)
  */
 void handleRoot(AsyncWebServerRequest *request) {
-    request->send(200, "text/html", index_html);
+    staticAssets.sendIndex(request);
+}
+
+/**
+ * @brief Calibration step 1: capture the dark reference (sensors covered)
+ */
+void handleCalibrateDark(AsyncWebServerRequest *request) {
+    LightSnapshot light;
+
+    if (!lightSampler.latest(light)) {
+        request->send(503, "text/plain", "No light data yet");
+        return;
+    }
+    lightCalibrationStore.captureDark(light);
+    request->send(200, "text/plain", "Dark reference captured");
+}
+
+/**
+ * @brief Calibration step 2: capture uniform light, compute, store and apply
+ *
+ * If NVS refuses the write the calibration still applies until the next
+ * cold boot, and the client gets a 500 saying so.
+ */
+void handleCalibrateLight(AsyncWebServerRequest *request) {
+    LightSnapshot light;
+    LightCalibration cal;
+    bool stored;
+
+    if (!lightSampler.latest(light) || !lightCalibrationStore.captureUniform(light, cal, stored)) {
+        request->send(409, "text/plain", "Capture dark first and use brighter uniform light");
+        return;
+    }
+    lightSampler.setCalibration(cal);
+    powerManager.saveCalibration(cal);
+    if (!stored) {
+        request->send(500, "text/plain", "Light calibration applied until reboot, storing it failed");
+        return;
+    }
+    request->send(200, "text/plain", "Light calibration stored");
+}
+
+/**
+ * @brief Current tracking thresholds, in the dashboard form's field names
+ */
+void handleGetSetpoint(AsyncWebServerRequest *request) {
+    TrackingConfig config;
+    char json[80];
+
+    trackingConfig.latest(config);
+    snprintf(json, sizeof(json), "{\"setpoint\":%u,\"maxLimit\":%u,\"minLimit\":%u}",
+             config.deadbandPercent, config.saturation, config.minIrradiance);
+    request->send(200, "application/json", json);
+}
+
+/**
+ * @brief Update the tracking thresholds from the dashboard form
+ *
+ * setpoint is required; an empty maxLimit or minLimit keeps its current
+ * value. The complete set is validated before anything changes, then
+ * published to the running tasks and stored in NVS.
+ */
+void handleSetpoint(AsyncWebServerRequest *request) {
+    static const char *const fields[] = {"setpoint", "maxLimit", "minLimit"};
+    TrackingConfig config;
+
+    if (!request->hasParam("setpoint", true) || request->getParam("setpoint", true)->value().length() == 0) {
+        request->send(400, "text/plain", "setpoint is required");
+        return;
+    }
+    const char *error = trackingConfigStore.update([request](TrackingConfig &edited) -> const char * {
+        for (const char *name : fields) {
+            if (request->hasParam(name, true) &&
+                !edited.setField(name, request->getParam(name, true)->value().c_str())) {
+                return "Values must be whole numbers";
+            }
+        }
+        return nullptr;
+    }, &config);
+    if (error) {
+        request->send(400, "text/plain", error);
+        return;
+    }
+
+    char text[64];
+    snprintf(text, sizeof(text), "setpoint %u%%, maxLimit %u, minLimit %u",
+             config.deadbandPercent, config.saturation, config.minIrradiance);
+    request->send(200, "text/plain", text);
+}
+
+/**
+ * @brief Web handler for the on-device history (binary, chunked)
+ *
+ * The export layout is described in HistoryStore.h. The response is
+ * produced slice by slice straight from the rings, so a week of data is
+ * sent without building it in memory.
+ */
+void handleHistory(AsyncWebServerRequest *request) {
+    HistoryStore::View view = history.view();
+
+    sendStream(request, "application/octet-stream",
+               [view](size_t offset, uint8_t *out, size_t len) -> size_t {
+                   return history.exportSlice(view, offset, out, len);
+               });
+}
+
+/**
+ * @brief Web handler for Prometheus metrics (text, chunked)
+ *
+ * Per-route request statistics from WebMetrics plus heap and task stack
+ * headroom, rendered line by line into the chunk buffer.
+ */
+void handleMetrics(AsyncWebServerRequest *request) {
+    sendStream(request, "text/plain; version=0.0.4",
+               [cursor = WebMetrics::Cursor()](size_t, uint8_t *out, size_t len) mutable -> size_t {
+                   return webMetrics.render(cursor, out, len);
+               });
+}
+
+/**
+ * @brief Gather the current value of everything /api/state reports
+ * @param state Destination
+ */
+void collectState(DeviceState& state) {
+    uint32_t now = millis();
+
+    state.lightValid = lightSampler.latest(state.light);
+    state.envValid = envSnapshots.latest(state.env) && state.env.valid &&
+                     now - state.env.timestampMs <= ENV_STALE_MS;
+    state.axisValid = axisLink.latest(state.axis, now);
+    state.uptimeSec = esp_timer_get_time() / 1000000;
+    state.rssiValid = WiFi.status() == WL_CONNECTED;
+    state.rssi = state.rssiValid ? WiFi.RSSI() : 0;
+}
+
+/**
+ * @brief Web handler for the combined state, JSON or CBOR by Accept header
+ */
+void handleState(AsyncWebServerRequest *request) {
+    DeviceState state;
+
+    collectState(state);
+    request->send(new StateResponse(state, wantsCbor(request)));
+}
+
+/**
+ * @brief UART receive callback: axis positions reported by the Pi
+ */
+void receiveAxes() {
+    uint8_t buffer[64];
+    size_t n;
+
+    while ((n = RP.read(buffer, sizeof(buffer))) > 0) {
+        axisLink.feed(buffer, n, millis());
+    }
+}
+
+/**
+ * @brief Add the latest environment and light readings to the history
+ * @param reading Result of the sensor cycle that just completed
+ */
+void recordHistory(const HtuReading& reading) {
+    int16_t values[HISTORY_FIELDS] = {HISTORY_INVALID, HISTORY_INVALID, HISTORY_INVALID};
+    LightSnapshot light;
+
+    if (reading.valid) {
+        values[HISTORY_TEMPERATURE] = reading.temperatureCenti;
+        values[HISTORY_HUMIDITY] = reading.humidityCenti;
+    }
+    if (lightSampler.latest(light)) {
+        values[HISTORY_IRRADIANCE] = computeSunError(light.level).irradiance;
+    }
+    history.record(values, millis() / 1000);
+}
+
+/**
+ * @brief One-shot timer callback: wake the sensor task for its next step
+ */
+void sensorStepTimer(void *arg) {
+    xTaskNotifyGive(static_cast<TaskHandle_t>(arg));
 }
 
 /**
  * @brief Task for reading temperature and humidity sensors
+ *
+ * Drives the HTU21D state machine. Between steps the task blocks on a
+ * notification from a one-shot timer, so the conversions cost no CPU and
+ * the I2C bus is only held for the transfers themselves. This task is the
+ * only I2C user; everyone else reads the published envSnapshots.
  * @param pvParameters Task parameters (unused)
  */
 void readSensorsTask(void *pvParameters) {
+    esp_timer_handle_t stepTimer;
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = sensorStepTimer;
+    timerArgs.arg = xTaskGetCurrentTaskHandle();
+    timerArgs.name = "htu_step";
+    esp_timer_create(&timerArgs, &stepTimer);
+
+    TickType_t lastWake = xTaskGetTickCount();
+
     for (;;) {
-        float temperature = humidity_temperature.getTemperature();
-        float humidity = humidity_temperature.getHumidity();
+        uint32_t wait;
+        while ((wait = sensor.step()) != 0) {
+            esp_timer_start_once(stepTimer, wait * 1000ULL);
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
 
-        Serial.printf("Temperature: %.2f °C | Humidity: %.2f %%\n", temperature, humidity);
+        const HtuReading& reading = sensor.lastReading();
+        publishEnvSnapshot(reading);
+        recordHistory(reading);
+        if (reading.valid) {
+            float temperature = reading.temperatureCenti / 100.0f;
+            float humidity = reading.humidityCenti / 100.0f;
 
-        display.showTempAndHumidity(temperature, humidity, 0, 90);
+            Serial.printf("Temperature: %.2f °C | Humidity: %.2f %%\n", temperature, humidity);
+            display.showTempAndHumidity(temperature, humidity, 0, 90);
+        }
         
-        vTaskDelay(pdMS_TO_TICKS(SENSOR_READ_INTERVAL));
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(SENSOR_READ_INTERVAL));
+    }
+}
+
+/**
+ * @brief Task that forwards the sun direction to the Raspberry Pi
+ *
+ * Reads the newest light snapshot at its own rate and sends one SUN_DIR
+ * line per new snapshot. Nothing is sent while the sky is diffuse,
+ * overcast or dark, while a sensor is saturated or while the error is
+ * inside the deadband, so the Pi leaves the motors alone. A slow or full
+ * UART only delays this task.
+ * @param pvParameters Task parameters (unused)
+ */
+void uartSenderTask(void *pvParameters) {
+    TrackingConfigReader config;
+    uint32_t lastSequence = 0;
+    TickType_t lastWake = xTaskGetTickCount();
+
+    for (;;) {
+        LightSnapshot light;
+        bool tracking = true;
+
+        if (lightSampler.latest(light) && light.sequence != lastSequence) {
+            lastSequence = light.sequence;
+            tracking = light.sky == SKY_CLEAR;
+
+            SunError error = computeSunError(light.level);
+            const TrackingConfig& thresholds = config.get();
+            bool hold = thresholds.saturated(light.level) || thresholds.withinDeadband(error);
+            if (tracking && !hold && RP.availableForWrite()) {
+                RP.printf("SUN_DIR:%s\n", sunDirectionName(error));
+            }
+        }
+
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(tracking ? UART_SEND_INTERVAL : UART_IDLE_INTERVAL));
+    }
+}
+
+/**
+ * @brief Format the current telemetry record
+ * @param buf Destination buffer (TELEMETRY_JSON_MAX)
+ * @param envSequence Receives the environment sequence used, 0 if none
+ * @return JSON length, 0 if no light data yet
+ */
+size_t buildTelemetry(char* buf, uint32_t& envSequence) {
+    LightSnapshot light;
+    EnvSnapshot env;
+
+    if (!lightSampler.latest(light)) {
+        return 0;
+    }
+    bool haveEnv = envSnapshots.latest(env);
+    envSequence = haveEnv ? env.sequence : 0;
+    return formatTelemetryJson(buf, TELEMETRY_JSON_MAX, light, haveEnv ? &env : nullptr);
+}
+
+/**
+ * @brief Task that broadcasts one telemetry event per environment sample
+ *
+ * All dashboard clients share the same event; with nobody connected the
+ * task only checks the client count.
+ * @param pvParameters Task parameters (unused)
+ */
+void telemetryTask(void *pvParameters) {
+    uint32_t lastSequence = 0;
+    char json[TELEMETRY_JSON_MAX];
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(TELEMETRY_INTERVAL));
+
+        if (events.count() == 0 || envSnapshots.published() == lastSequence) {
+            continue;
+        }
+
+        uint32_t sequence;
+        size_t len = buildTelemetry(json, sequence);
+        if (len) {
+            events.send(json, TELEMETRY_EVENT_NAME, sequence);
+            lastSequence = sequence;
+        }
+    }
+}
+
+/**
+ * @brief Task that streams binary telemetry frames over the WebSocket
+ *
+ * One frame per interval is queued to every client. The library caps each
+ * client's queue at WS_MAX_QUEUED_MESSAGES; a client that cannot keep up
+ * loses intermediate frames instead of growing the heap, and never slows
+ * the other clients or the sampler.
+ * @param pvParameters Task parameters (unused)
+ */
+void wsStreamTask(void *pvParameters) {
+    TickType_t lastWake = xTaskGetTickCount();
+    uint32_t lastCleanup = millis();
+    uint32_t lastSequence = 0;
+
+    for (;;) {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(WS_STREAM_INTERVAL));
+
+        if (millis() - lastCleanup >= WS_CLEANUP_INTERVAL) {
+            ws.cleanupClients();
+            lastCleanup = millis();
+        }
+
+        LightSnapshot light;
+        if (ws.count() == 0 || !lightSampler.latest(light) || light.sequence == lastSequence) {
+            continue;
+        }
+        lastSequence = light.sequence;
+
+        EnvSnapshot env;
+        TelemetryFrame frame;
+        buildTelemetryFrame(frame, light, envSnapshots.latest(env) ? &env : nullptr);
+        ws.binaryAll(reinterpret_cast<const uint8_t*>(&frame), sizeof(frame));
+    }
+}
+
+/**
+ * @brief Task that batches telemetry frames for the MQTT broker
+ *
+ * Samples one frame per MQTT_SAMPLE_INTERVAL whether or not the broker is
+ * reachable; finished batches wait in the publisher's RAM queue and are
+ * flushed once the connection is back.
+ * @param pvParameters Task parameters (unused)
+ */
+void mqttTask(void *pvParameters) {
+    TickType_t lastWake = xTaskGetTickCount();
+
+    for (;;) {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(MQTT_SAMPLE_INTERVAL));
+
+        LightSnapshot light;
+        if (lightSampler.latest(light)) {
+            EnvSnapshot env;
+            TelemetryFrame frame;
+            buildTelemetryFrame(frame, light, envSnapshots.latest(env) ? &env : nullptr);
+            mqtt.addSample(frame);
+        }
+        mqtt.flush();
+    }
+}
+
+/**
+ * @brief WebSocket events: slow clients drop frames rather than being closed
+ */
+void handleWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type,
+                   void *arg, uint8_t *data, size_t len) {
+    if (type == WS_EVT_CONNECT) {
+        client->setCloseClientOnQueueFull(false);
+        Serial.printf("WebSocket client #%u connected\n", client->id());
+    } else if (type == WS_EVT_DISCONNECT) {
+        Serial.printf("WebSocket client #%u disconnected\n", client->id());
     }
 }
 
@@ -89,16 +478,47 @@ void setupHardware() {
     Wire.setClock(100000);
     Wire.begin(SDA_PIN, SCL_PIN);
     Serial.println("I2C initialized");
+    sensor.begin();
     
     // Initialize UART for Raspberry Pi communication
     RP.begin(UART_BAUD, SERIAL_8N1, RX_PIN, TX_PIN);
+    RP.onReceive(receiveAxes);
     Serial.println("UART initialized");
+
+    // All history memory is allocated here, once
+    history.begin();
     
     // Initialize Light Sensors
     leftSensor.initLight();
     rightSensor.initLight();
     upSensor.initLight();
     downSensor.initLight();
+
+    // A night timer wake that is still dark goes straight back to sleep
+    powerManager.begin();
+    if (powerManager.wokeFromNight() && powerManager.stillDark()) {
+        powerManager.enterNightSleep();
+    }
+
+    adcCalibration.begin();
+
+    LightCalibration lightCalibration;
+    if (!powerManager.restoreCalibration(lightCalibration)) {
+        lightCalibrationStore.load(lightCalibration);
+        powerManager.saveCalibration(lightCalibration);
+    }
+    lightSampler.setCalibration(lightCalibration);
+
+    SkyCondition lastSky;
+    if (powerManager.restoreSky(lastSky)) {
+        lightSampler.restoreSky(lastSky);
+    }
+
+    TrackingConfig thresholds;
+    trackingConfigStore.load(thresholds);
+    trackingConfigStore.apply(thresholds, false);
+
+    lightSampler.begin(LIGHT_SENSE_RATE_HZ);
     Serial.println("Light sensors initialized");
 }
 
@@ -106,11 +526,48 @@ void setupHardware() {
  * @brief Initialize web server endpoints
  */
 void setupWebServer() {
+    // Admit and measure every route, including the static assets and the streams
+    admission.begin(classifyRequest, ws, events);
+    webMetrics.setAdmission(admission);
+    server.addMiddleware(&webMetrics);
+    webMetrics.watchTask("loopTask");
+    webMetrics.watchTask("async_tcp");
+    webMetrics.watchTask("LightSampler");
+    webMetrics.watchTask("SensorReadTask");
+    webMetrics.watchTask("UartSendTask");
+    webMetrics.watchTask("TelemetryTask");
+    webMetrics.watchTask("WsStreamTask");
+    webMetrics.watchTask("MqttTask");
+
+    staticAssets.begin(server);
     server.on("/", HTTP_GET, handleRoot);
     server.on("/temperature", HTTP_GET, handleTemperature);
     server.on("/humidity", HTTP_GET, handleHumidity);
     server.on("/graph_Temp", HTTP_GET, handleTemperature);
     server.on("/graph_Humidity", HTTP_GET, handleHumidity);
+    server.on("/calibrate/dark", HTTP_POST, handleCalibrateDark);
+    server.on("/calibrate/light", HTTP_POST, handleCalibrateLight);
+    server.on("/history", HTTP_GET, handleHistory);
+    server.on("/api/state", HTTP_GET, handleState);
+    server.on("/setpoint", HTTP_GET, handleGetSetpoint);
+    server.on("/setpoint", HTTP_POST, handleSetpoint);
+    server.on("/metrics", HTTP_GET, handleMetrics);
+#ifdef ENABLE_STREAM_SELFTEST
+    streamSelftest.begin(server);
+#endif
+
+    // New dashboard clients get the current state at once instead of waiting a sample
+    events.onConnect([](AsyncEventSourceClient *client) {
+        char json[TELEMETRY_JSON_MAX];
+        uint32_t sequence;
+        if (buildTelemetry(json, sequence)) {
+            client->send(json, TELEMETRY_EVENT_NAME, sequence, TELEMETRY_RETRY_MS);
+        }
+    });
+    server.addHandler(&events);
+
+    ws.onEvent(handleWsEvent);
+    server.addHandler(&ws);
     
     server.begin();
     Serial.println("Web server started");
@@ -126,8 +583,14 @@ void setup() {
     // Initialize hardware
     setupHardware();
     
-    // Initialize WiFi and display
-    HandleWiFi_init(WIFI_SSID, WIFI_PASSWORD);
+    // Initialize WiFi and display; after a night wake try the cached AP first
+    if (powerManager.fastConnect(WIFI_SSID, WIFI_PASSWORD)) {
+        esp_task_wdt_add(NULL);
+        display.initDisplay();
+    } else {
+        HandleWiFi_init(WIFI_SSID, WIFI_PASSWORD);
+    }
+    powerManager.rememberWiFi();
     
     // Create sensor reading task on Core 1
     xTaskCreatePinnedToCore(
@@ -140,44 +603,105 @@ void setup() {
         1               // Core ID
     );
     
+    // Forward light decisions to the Raspberry Pi on Core 1
+    xTaskCreatePinnedToCore(
+        uartSenderTask,
+        "UartSendTask",
+        3072,           // Stack size
+        NULL,           // Parameters
+        UART_TASK_PRIO, // Priority
+        NULL,           // Task handle
+        1               // Core ID
+    );
+    
     // Initialize web server
     setupWebServer();
+
+    // Push telemetry to dashboard clients on Core 0, next to the network stack
+    xTaskCreatePinnedToCore(
+        telemetryTask,
+        "TelemetryTask",
+        4096,           // Stack size
+        NULL,           // Parameters
+        1,              // Priority
+        NULL,           // Task handle
+        0               // Core ID
+    );
+
+    // Binary WebSocket stream, also next to the network stack
+    xTaskCreatePinnedToCore(
+        wsStreamTask,
+        "WsStreamTask",
+        3072,           // Stack size
+        NULL,           // Parameters
+        1,              // Priority
+        NULL,           // Task handle
+        0               // Core ID
+    );
+
+    // Batched telemetry to the MQTT broker, if one is configured
+    if (mqtt.begin(MQTT_BROKER_URI, trackingConfigStore)) {
+        xTaskCreatePinnedToCore(
+            mqttTask,
+            "MqttTask",
+            3072,           // Stack size
+            NULL,           // Parameters
+            1,              // Priority
+            NULL,           // Task handle
+            0               // Core ID
+        );
+    }
     
     Serial.println("=== Setup Complete ===");
     Serial.printf("IP Address: %s\n", WiFi.localIP().toString().c_str());
 }
 
 /**
- * @brief Arduino main loop - runs continuously
+ * @brief Arduino main loop - refreshes the local display
+ *
+ * Light sampling and the UART link run in their own tasks; the loop only
+ * shows the newest snapshot at DISPLAY_INTERVAL.
  */
 void loop() {
-    // Read light sensor values
-    int leftValue = analogRead(LIGHT_LEFT_PIN);
-    int rightValue = analogRead(LIGHT_RIGHT_PIN);
-    int upValue = analogRead(LIGHT_UP_PIN);
-    int downValue = analogRead(LIGHT_DOWN_PIN);
+    // One snapshot per tick, shared by every line on the display
+    LightSnapshot light = {};
+    lightSampler.latest(light);
+
+    int leftValue = light.level[LIGHT_LEFT];
+    int rightValue = light.level[LIGHT_RIGHT];
+    int upValue = light.level[LIGHT_UP];
+    int downValue = light.level[LIGHT_DOWN];
     
     // Display light intensities on TFT
-    leftSensor.logLightIntensity(display, 0, 30);
-    rightSensor.logLightIntensity(display, 0, 40);
-    upSensor.logLightIntensity(display, 0, 50);
-    downSensor.logLightIntensity(display, 0, 60);
+    leftSensor.logLightIntensity(display, leftValue,
+                                 adcCalibration.toMillivoltsQ4(light.filtered[LIGHT_LEFT]), 0, 30);
+    rightSensor.logLightIntensity(display, rightValue,
+                                  adcCalibration.toMillivoltsQ4(light.filtered[LIGHT_RIGHT]), 0, 40);
+    upSensor.logLightIntensity(display, upValue,
+                               adcCalibration.toMillivoltsQ4(light.filtered[LIGHT_UP]), 0, 50);
+    downSensor.logLightIntensity(display, downValue,
+                                 adcCalibration.toMillivoltsQ4(light.filtered[LIGHT_DOWN]), 0, 60);
     
-    // Determine sun direction and send to Raspberry Pi
-    String direction = leftSensor.getSunDirection(leftValue, rightValue, upValue, downValue);
-    
-    // Send direction to Raspberry Pi via UART
-    if (RP.availableForWrite()) {
-        RP.printf("SUN_DIR:%s\n", direction.c_str());
-    }
+    // Sun direction as sent to the Raspberry Pi by uartSenderTask
+    SunError error = computeSunError(light.level);
+    const char* direction = sunDirectionName(error);
+    Serial.printf("Sun error: az %d, el %d (/4096), irradiance %u, confidence %u, sky %s -> %s\n",
+                  error.azimuth, error.elevation, error.irradiance, error.confidence,
+                  skyConditionName(light.sky), light.sky == SKY_CLEAR ? direction : "hold");
     
     // Display on local TFT
     int maxValue = max(max(leftValue, rightValue), max(upValue, downValue));
     display.showDirection(direction, maxValue, 10, 100);
     
+    // Sleep through the night once darkness has persisted
+    if (powerManager.update(light)) {
+        display.sleep();
+        powerManager.enterNightSleep();
+    }
+    
     // Reset watchdog timer
     esp_task_wdt_reset();
     
-    // Delay before next reading
-    delay(LIGHT_READ_INTERVAL);
+    // Delay before next refresh
+    delay(DISPLAY_INTERVAL);
 }
@@ -0,0 +1,85 @@
+/**
+ * @file Arduino.h
+ * @brief Host stand-in for the parts of the Arduino core the tested headers use
+ * @author Yahya
+ *
+ * Only for the native test env. millis() is driven by the tests through
+ * stubMillis, FreeRTOS tasks exist when listed in stubTaskStacks, and
+ * critical sections are plain mutexes.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <string>
+
+using std::max;
+using std::min;
+
+inline uint32_t stubMillis = 0;
+
+inline uint32_t millis() {
+    return stubMillis;
+}
+
+class String : public std::string {
+public:
+    String(const char* text = "") : std::string(text) {}
+    String(const std::string& text) : std::string(text) {}
+
+    long toInt() const {
+        return atol(c_str());
+    }
+
+    bool startsWith(const char* prefix) const {
+        return rfind(prefix, 0) == 0;
+    }
+
+    bool equals(const char* other) const {
+        return compare(other) == 0;
+    }
+
+    int indexOf(const char* other) const {
+        size_t at = find(other);
+        return at == npos ? -1 : (int)at;
+    }
+};
+
+class HardwareSerial {
+public:
+    template <typename... Args>
+    void printf(const char* format, Args... args) {
+        ::printf(format, args...);
+    }
+
+    void println(const char* text) {
+        puts(text);
+    }
+};
+
+inline HardwareSerial Serial;
+
+typedef void* TaskHandle_t;
+
+inline std::map<std::string, unsigned> stubTaskStacks;     // Name to stack high-water mark
+
+inline TaskHandle_t xTaskGetHandle(const char* name) {
+    auto task = stubTaskStacks.find(name);
+    return task == stubTaskStacks.end() ? nullptr : &task->second;
+}
+
+inline unsigned uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    return *static_cast<unsigned*>(task);
+}
+
+typedef std::mutex portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {}
+#define portENTER_CRITICAL(mux) (mux)->lock()
+#define portEXIT_CRITICAL(mux) (mux)->unlock()
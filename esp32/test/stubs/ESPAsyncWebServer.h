@@ -0,0 +1,221 @@
+/**
+ * @file ESPAsyncWebServer.h
+ * @brief Host stand-in for the parts of ESPAsyncWebServer the web headers use
+ * @author Yahya
+ *
+ * Requests are plain objects the tests fill in (url, headers, params,
+ * client address) and hand to a middleware or a registered handler. The
+ * response a handler sends is kept on the request; disconnect() runs the
+ * onDisconnect callback the way the library does when the client goes.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include "Arduino.h"
+
+class AsyncWebServerRequest;
+
+typedef std::function<void(void)> ArMiddlewareNext;
+typedef std::function<void(void)> ArDisconnectHandler;
+typedef std::function<void(AsyncWebServerRequest*)> ArRequestHandlerFunction;
+typedef std::function<size_t(uint8_t*, size_t, size_t)> AwsResponseFiller;
+
+enum WebRequestMethod {
+    HTTP_GET = 1,
+    HTTP_POST = 2
+};
+
+class AsyncMiddleware {
+public:
+    virtual ~AsyncMiddleware() {}
+    virtual void run(AsyncWebServerRequest* request, ArMiddlewareNext next) = 0;
+};
+
+class AsyncWebServerResponse {
+protected:
+    int _code;
+    size_t _writtenLength = 0;
+
+public:
+    std::string contentType;
+    std::string body;
+    AwsResponseFiller filler;                   // Set for chunked responses
+    std::map<std::string, std::string> headers;
+
+    AsyncWebServerResponse(int code, const char* type, const char* content = "")
+        : _code(code), contentType(type), body(content) {}
+    virtual ~AsyncWebServerResponse() {}
+
+    void addHeader(const char* name, const char* value) {
+        headers[name] = value;
+    }
+
+    int code() const {
+        return _code;
+    }
+
+    /**
+     * @brief Record how many bytes the library wrote to the client (test helper)
+     */
+    void setWritten(size_t bytes) {
+        _writtenLength = bytes;
+    }
+};
+
+class AsyncWebParameter {
+private:
+    String text;
+
+public:
+    explicit AsyncWebParameter(const std::string& value) : text(value) {}
+
+    const String& value() const {
+        return text;
+    }
+};
+
+struct IPAddress {
+    uint32_t address;
+
+    operator uint32_t() const {
+        return address;
+    }
+};
+
+class AsyncClient {
+public:
+    uint32_t address = 0x0100007F;
+
+    IPAddress remoteIP() const {
+        return {address};
+    }
+};
+
+class AsyncWebServerRequest {
+private:
+    std::unique_ptr<AsyncWebServerResponse> response;
+    std::map<std::string, std::unique_ptr<AsyncWebParameter>> paramValues;
+    ArDisconnectHandler disconnectHandler;
+
+public:
+    String path = "/";
+    std::map<std::string, std::string> headers;
+    std::map<std::string, std::string> params;
+    AsyncClient tcp;
+
+    explicit AsyncWebServerRequest(const char* url = "/") : path(url) {}
+
+    String url() const {
+        return path;
+    }
+
+    bool hasHeader(const char* name) const {
+        return headers.count(name) > 0;
+    }
+
+    String header(const char* name) const {
+        auto value = headers.find(name);
+        return value == headers.end() ? String() : String(value->second);
+    }
+
+    bool hasParam(const char* name, bool post = false) const {
+        (void)post;
+        return params.count(name) > 0;
+    }
+
+    AsyncWebParameter* getParam(const char* name, bool post = false) {
+        (void)post;
+        auto value = params.find(name);
+        if (value == params.end()) {
+            return nullptr;
+        }
+        paramValues[name] = std::make_unique<AsyncWebParameter>(value->second);
+        return paramValues[name].get();
+    }
+
+    AsyncClient* client() {
+        return &tcp;
+    }
+
+    AsyncWebServerResponse* beginResponse(int code, const char* type, const char* content) {
+        return new AsyncWebServerResponse(code, type, content);
+    }
+
+    AsyncWebServerResponse* beginChunkedResponse(const char* type, AwsResponseFiller filler) {
+        AsyncWebServerResponse* chunked = new AsyncWebServerResponse(200, type);
+        chunked->filler = filler;
+        return chunked;
+    }
+
+    void send(AsyncWebServerResponse* sent) {
+        response.reset(sent);
+    }
+
+    void send(int code, const char* type, const char* content) {
+        send(beginResponse(code, type, content));
+    }
+
+    AsyncWebServerResponse* getResponse() const {
+        return response.get();
+    }
+
+    void onDisconnect(ArDisconnectHandler handler) {
+        disconnectHandler = handler;
+    }
+
+    /**
+     * @brief The client went away: run the onDisconnect callback once (test helper)
+     */
+    void disconnect() {
+        if (disconnectHandler) {
+            ArDisconnectHandler handler = disconnectHandler;
+            disconnectHandler = nullptr;
+            handler();
+        }
+    }
+};
+
+class AsyncWebServer {
+public:
+    std::map<std::string, ArRequestHandlerFunction> handlers;
+
+    void on(const char* uri, WebRequestMethod method, ArRequestHandlerFunction handler) {
+        (void)method;
+        handlers[uri] = handler;
+    }
+
+    /**
+     * @brief Run the handler registered for the request's exact url (test helper)
+     */
+    bool handle(AsyncWebServerRequest* request) {
+        auto handler = handlers.find(request->url());
+        if (handler == handlers.end()) {
+            return false;
+        }
+        handler->second(request);
+        return true;
+    }
+};
+
+class AsyncWebSocket {
+public:
+    size_t clients = 0;
+
+    size_t count() const {
+        return clients;
+    }
+};
+
+class AsyncEventSource {
+public:
+    size_t clients = 0;
+
+    size_t count() const {
+        return clients;
+    }
+};
@@ -0,0 +1,41 @@
+/**
+ * @file FS.h
+ * @brief Host stand-in for the Arduino File class, reading from memory
+ * @author Yahya
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+
+class File {
+private:
+    std::shared_ptr<const std::string> data;
+    size_t pos = 0;
+
+public:
+    File() = default;
+    explicit File(std::shared_ptr<const std::string> content) : data(content) {}
+
+    explicit operator bool() const {
+        return data != nullptr;
+    }
+
+    bool isDirectory() const {
+        return false;
+    }
+
+    size_t read(uint8_t* out, size_t len) {
+        if (!data) {
+            return 0;
+        }
+        size_t n = std::min(len, data->size() - pos);
+        memcpy(out, data->data() + pos, n);
+        pos += n;
+        return n;
+    }
+};
@@ -0,0 +1,30 @@
+/**
+ * @file LittleFS.h
+ * @brief Host stand-in for LittleFS: files are strings the tests add
+ * @author Yahya
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include "FS.h"
+
+class StubFS {
+private:
+    std::map<std::string, std::shared_ptr<const std::string>> files;
+
+public:
+    void add(const std::string& path, const std::string& content) {
+        files[path] = std::make_shared<const std::string>(content);
+    }
+
+    File open(const std::string& path, const char* mode) {
+        (void)mode;
+        auto file = files.find(path);
+        return file == files.end() ? File() : File(file->second);
+    }
+};
+
+inline StubFS LittleFS;
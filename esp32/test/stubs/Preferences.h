@@ -0,0 +1,51 @@
+/**
+ * @file Preferences.h
+ * @brief Host stand-in for the ESP32 NVS Preferences library, kept in memory
+ * @author Yahya
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <map>
+#include <string>
+
+class Preferences {
+private:
+    std::string space;
+
+    static std::map<std::string, std::string>& storage() {
+        static std::map<std::string, std::string> entries;
+        return entries;
+    }
+
+public:
+    bool begin(const char* name, bool readOnly = false) {
+        (void)readOnly;
+        space = name;
+        return true;
+    }
+
+    void end() {}
+
+    size_t getBytes(const char* key, void* buf, size_t maxLen) {
+        auto entry = storage().find(space + "/" + key);
+        if (entry == storage().end() || entry->second.size() > maxLen) {
+            return 0;
+        }
+        memcpy(buf, entry->second.data(), entry->second.size());
+        return entry->second.size();
+    }
+
+    size_t putBytes(const char* key, const void* value, size_t len) {
+        storage()[space + "/" + key].assign((const char*)value, len);
+        return len;
+    }
+
+    /**
+     * @brief Forget everything stored (test helper)
+     */
+    static void clearAll() {
+        storage().clear();
+    }
+};
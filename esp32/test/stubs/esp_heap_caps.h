@@ -0,0 +1,36 @@
+/**
+ * @file esp_heap_caps.h
+ * @brief Host stand-in for the ESP-IDF heap statistics, set by the tests
+ * @author Yahya
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT 0
+
+inline size_t stubHeapFree = 200000;
+inline size_t stubHeapMinFree = 150000;
+inline size_t stubHeapLargest = 110000;
+
+inline void* heap_caps_malloc(size_t size, int caps) {
+    (void)caps;
+    return malloc(size);
+}
+
+inline size_t heap_caps_get_free_size(int caps) {
+    (void)caps;
+    return stubHeapFree;
+}
+
+inline size_t heap_caps_get_minimum_free_size(int caps) {
+    (void)caps;
+    return stubHeapMinFree;
+}
+
+inline size_t heap_caps_get_largest_free_block(int caps) {
+    (void)caps;
+    return stubHeapLargest;
+}
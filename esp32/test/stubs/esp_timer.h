@@ -0,0 +1,15 @@
+/**
+ * @file esp_timer.h
+ * @brief Host stand-in for the ESP-IDF microsecond clock, set by the tests
+ * @author Yahya
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+inline int64_t stubTimeUs = 0;
+
+inline int64_t esp_timer_get_time() {
+    return stubTimeUs;
+}
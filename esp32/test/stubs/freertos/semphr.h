@@ -0,0 +1,30 @@
+/**
+ * @file semphr.h
+ * @brief Host stand-in for the FreeRTOS mutex calls, backed by std::mutex
+ * @author Yahya
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <mutex>
+
+#define portMAX_DELAY 0xFFFFFFFFu
+
+typedef std::mutex StaticSemaphore_t;
+typedef std::mutex* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t* buffer) {
+    return buffer;
+}
+
+inline int xSemaphoreTake(SemaphoreHandle_t mutex, uint32_t ticks) {
+    (void)ticks;
+    mutex->lock();
+    return 1;
+}
+
+inline int xSemaphoreGive(SemaphoreHandle_t mutex) {
+    mutex->unlock();
+    return 1;
+}
@@ -0,0 +1,126 @@
+/**
+ * @file test_main.cpp
+ * @brief Native tests for the AXIS line parser in AxisLink.h
+ * @author Yahya
+ *
+ * Run with: pio test -e native -f test_axis_link
+ */
+
+#include <unity.h>
+#include "AxisLink.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void feedText(AxisLink& link, const char* text, uint32_t nowMs) {
+    link.feed((const uint8_t*)text, strlen(text), nowMs);
+}
+
+void test_parse_valid_lines(void) {
+    int32_t azimuth = 0;
+    int32_t elevation = 0;
+
+    TEST_ASSERT_TRUE(AxisLink::parse("AXIS:120,45", azimuth, elevation));
+    TEST_ASSERT_EQUAL_INT32(120, azimuth);
+    TEST_ASSERT_EQUAL_INT32(45, elevation);
+
+    TEST_ASSERT_TRUE(AxisLink::parse("AXIS:-350,90", azimuth, elevation));
+    TEST_ASSERT_EQUAL_INT32(-350, azimuth);
+    TEST_ASSERT_EQUAL_INT32(90, elevation);
+}
+
+void test_parse_rejects_malformed_lines(void) {
+    int32_t azimuth = 7;
+    int32_t elevation = 7;
+
+    TEST_ASSERT_FALSE(AxisLink::parse("", azimuth, elevation));
+    TEST_ASSERT_FALSE(AxisLink::parse("SUN_DIR:Op", azimuth, elevation));
+    TEST_ASSERT_FALSE(AxisLink::parse("AXIS:", azimuth, elevation));
+    TEST_ASSERT_FALSE(AxisLink::parse("AXIS:12", azimuth, elevation));
+    TEST_ASSERT_FALSE(AxisLink::parse("AXIS:12,", azimuth, elevation));
+    TEST_ASSERT_FALSE(AxisLink::parse("AXIS:,45", azimuth, elevation));
+    TEST_ASSERT_FALSE(AxisLink::parse("AXIS:12,45x", azimuth, elevation));
+    TEST_ASSERT_FALSE(AxisLink::parse("AXIS:12;45", azimuth, elevation));
+}
+
+void test_feed_assembles_split_lines(void) {
+    AxisLink link;
+    AxisSnapshot snap;
+
+    TEST_ASSERT_FALSE(link.latest(snap, 0));
+
+    feedText(link, "AXI", 100);
+    feedText(link, "S:-5,", 100);
+    TEST_ASSERT_FALSE(link.latest(snap, 100));
+    feedText(link, "60\r\n", 150);
+
+    TEST_ASSERT_TRUE(link.latest(snap, 150));
+    TEST_ASSERT_EQUAL_INT32(-5, snap.azimuth);
+    TEST_ASSERT_EQUAL_INT32(60, snap.elevation);
+    TEST_ASSERT_EQUAL_UINT32(150, snap.timestampMs);
+    TEST_ASSERT_EQUAL_UINT32(1, snap.sequence);
+
+    // Several lines in one chunk: the newest wins
+    feedText(link, "AXIS:1,10\nAXIS:2,20\n", 200);
+    TEST_ASSERT_TRUE(link.latest(snap, 200));
+    TEST_ASSERT_EQUAL_INT32(2, snap.azimuth);
+    TEST_ASSERT_EQUAL_UINT32(3, snap.sequence);
+    TEST_ASSERT_EQUAL_UINT32(0, link.parseErrors());
+}
+
+void test_feed_counts_bad_lines(void) {
+    AxisLink link;
+    AxisSnapshot snap;
+
+    feedText(link, "AXIS:3,30\n", 10);
+    feedText(link, "garbage\n\n\r\nAXIS:x,1\n", 20);   // Empty lines are not errors
+
+    TEST_ASSERT_EQUAL_UINT32(2, link.parseErrors());
+    TEST_ASSERT_TRUE(link.latest(snap, 20));
+    TEST_ASSERT_EQUAL_INT32(3, snap.azimuth);           // Bad lines change nothing
+}
+
+void test_feed_drops_overlong_lines(void) {
+    AxisLink link;
+    AxisSnapshot snap;
+    char text[AXIS_LINE_MAX * 2];
+
+    // A valid report with padding past the buffer must not be half-parsed
+    memset(text, '0', sizeof(text));
+    memcpy(text, "AXIS:1,", 7);
+    text[sizeof(text) - 2] = '5';
+    text[sizeof(text) - 1] = '\n';
+    link.feed((const uint8_t*)text, sizeof(text), 10);
+
+    TEST_ASSERT_FALSE(link.latest(snap, 10));
+    TEST_ASSERT_EQUAL_UINT32(1, link.parseErrors());
+
+    // The next line is parsed normally
+    feedText(link, "AXIS:4,40\n", 20);
+    TEST_ASSERT_TRUE(link.latest(snap, 20));
+    TEST_ASSERT_EQUAL_INT32(4, snap.azimuth);
+}
+
+void test_latest_goes_stale(void) {
+    AxisLink link;
+    AxisSnapshot snap;
+
+    feedText(link, "AXIS:8,80\n", 1000);
+    TEST_ASSERT_TRUE(link.latest(snap, 1000 + AXIS_STALE_MS));
+    TEST_ASSERT_FALSE(link.latest(snap, 1000 + AXIS_STALE_MS + 1));
+
+    // millis() wrapping around does not make a fresh report stale
+    feedText(link, "AXIS:9,90\n", 0xFFFFFF00u);
+    TEST_ASSERT_TRUE(link.latest(snap, 0x100));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_valid_lines);
+    RUN_TEST(test_parse_rejects_malformed_lines);
+    RUN_TEST(test_feed_assembles_split_lines);
+    RUN_TEST(test_feed_counts_bad_lines);
+    RUN_TEST(test_feed_drops_overlong_lines);
+    RUN_TEST(test_latest_goes_stale);
+    return UNITY_END();
+}
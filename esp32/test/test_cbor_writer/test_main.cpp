@@ -0,0 +1,97 @@
+/**
+ * @file test_main.cpp
+ * @brief Native tests for CborWriter against the RFC 8949 Appendix A examples
+ * @author Yahya
+ *
+ * Run with: pio test -e native -f test_cbor_writer
+ */
+
+#include <unity.h>
+#include "CborWriter.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static uint8_t buffer[64];
+
+#define ASSERT_ENCODED(writer, ...) do { \
+        const uint8_t expected[] = { __VA_ARGS__ }; \
+        TEST_ASSERT_EQUAL_size_t(sizeof(expected), (writer).finish()); \
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, buffer, sizeof(expected)); \
+    } while (0)
+
+static size_t encodeInteger(int32_t value) {
+    CborWriter cbor(buffer, sizeof(buffer));
+    cbor.integer(value);
+    return cbor.finish();
+}
+
+void test_unsigned_integers(void) {
+    { CborWriter c(buffer, sizeof(buffer)); c.integer(0); ASSERT_ENCODED(c, 0x00); }
+    { CborWriter c(buffer, sizeof(buffer)); c.integer(23); ASSERT_ENCODED(c, 0x17); }
+    { CborWriter c(buffer, sizeof(buffer)); c.integer(24); ASSERT_ENCODED(c, 0x18, 0x18); }
+    { CborWriter c(buffer, sizeof(buffer)); c.integer(100); ASSERT_ENCODED(c, 0x18, 0x64); }
+    { CborWriter c(buffer, sizeof(buffer)); c.integer(1000); ASSERT_ENCODED(c, 0x19, 0x03, 0xE8); }
+    { CborWriter c(buffer, sizeof(buffer)); c.integer(1000000); ASSERT_ENCODED(c, 0x1A, 0x00, 0x0F, 0x42, 0x40); }
+}
+
+void test_negative_integers(void) {
+    { CborWriter c(buffer, sizeof(buffer)); c.integer(-1); ASSERT_ENCODED(c, 0x20); }
+    { CborWriter c(buffer, sizeof(buffer)); c.integer(-10); ASSERT_ENCODED(c, 0x29); }
+    { CborWriter c(buffer, sizeof(buffer)); c.integer(-100); ASSERT_ENCODED(c, 0x38, 0x63); }
+    { CborWriter c(buffer, sizeof(buffer)); c.integer(-1000); ASSERT_ENCODED(c, 0x39, 0x03, 0xE7); }
+    { CborWriter c(buffer, sizeof(buffer)); c.integer(INT32_MIN); ASSERT_ENCODED(c, 0x3A, 0x7F, 0xFF, 0xFF, 0xFF); }
+    TEST_ASSERT_EQUAL_size_t(5, encodeInteger(INT32_MAX));
+}
+
+void test_float32(void) {
+    { CborWriter c(buffer, sizeof(buffer)); c.number(100000.0f); ASSERT_ENCODED(c, 0xFA, 0x47, 0xC3, 0x50, 0x00); }
+    { CborWriter c(buffer, sizeof(buffer)); c.number(1.5f); ASSERT_ENCODED(c, 0xFA, 0x3F, 0xC0, 0x00, 0x00); }
+    { CborWriter c(buffer, sizeof(buffer)); c.number(-4.0f); ASSERT_ENCODED(c, 0xFA, 0xC0, 0x80, 0x00, 0x00); }
+}
+
+void test_text_is_utf8_bytes(void) {
+    { CborWriter c(buffer, sizeof(buffer)); c.text(""); ASSERT_ENCODED(c, 0x60); }
+    { CborWriter c(buffer, sizeof(buffer)); c.text("IETF"); ASSERT_ENCODED(c, 0x64, 0x49, 0x45, 0x54, 0x46); }
+    { CborWriter c(buffer, sizeof(buffer)); c.text("ü"); ASSERT_ENCODED(c, 0x62, 0xC3, 0xBC); }
+    { CborWriter c(buffer, sizeof(buffer)); c.text("水"); ASSERT_ENCODED(c, 0x63, 0xE6, 0xB0, 0xB4); }
+}
+
+void test_containers_and_null(void) {
+    CborWriter c(buffer, sizeof(buffer));
+
+    // {"a": 1, "b": [2, 3], "c": null}
+    c.map(3);
+    c.text("a");
+    c.integer(1);
+    c.text("b");
+    c.array(2);
+    c.integer(2);
+    c.integer(3);
+    c.text("c");
+    c.null();
+    ASSERT_ENCODED(c, 0xA3, 0x61, 0x61, 0x01, 0x61, 0x62, 0x82, 0x02, 0x03, 0x61, 0x63, 0xF6);
+}
+
+void test_overflow_reports_zero(void) {
+    CborWriter exact(buffer, 3);
+    exact.integer(1000);
+    TEST_ASSERT_EQUAL_size_t(3, exact.finish());
+
+    buffer[4] = 0xAA;
+    CborWriter small(buffer, 4);
+    small.text("IETF");
+    TEST_ASSERT_EQUAL_size_t(0, small.finish());
+    TEST_ASSERT_EQUAL_UINT8(0xAA, buffer[4]);      // Nothing written past the end
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_unsigned_integers);
+    RUN_TEST(test_negative_integers);
+    RUN_TEST(test_float32);
+    RUN_TEST(test_text_is_utf8_bytes);
+    RUN_TEST(test_containers_and_null);
+    RUN_TEST(test_overflow_reports_zero);
+    return UNITY_END();
+}
@@ -0,0 +1,137 @@
+/**
+ * @file test_main.cpp
+ * @brief Native tests for sendStream() and the stream selftest routes
+ * @author Yahya
+ *
+ * Run with: pio test -e native -f test_chunked_stream
+ */
+
+#define ENABLE_STREAM_SELFTEST
+
+#include <unity.h>
+#include "ChunkedStream.h"
+
+static AsyncWebServer server;
+static StreamSelftest selftest;
+
+void setUp(void) {
+    stubHeapFree = 200000;
+    stubHeapLargest = 110000;
+}
+
+void tearDown(void) {}
+
+/**
+ * @brief Drain a chunked response the way the library does, with a send
+ *        window that changes from call to call
+ */
+static std::string drain(AsyncWebServerResponse* response, size_t* largestCall) {
+    static uint8_t buffer[5000];
+    std::string body;
+    size_t n;
+
+    *largestCall = 0;
+    TEST_ASSERT_TRUE(response->filler != nullptr);
+    while ((n = response->filler(buffer, 700 + body.size() % 4000, body.size())) > 0) {
+        *largestCall = max(*largestCall, n);
+        body.append((const char*)buffer, n);
+        stubHeapFree = 190000 - body.size() % 7000;
+    }
+    return body;
+}
+
+/**
+ * @brief Payload stream_selftest.py expects: little-endian 32-bit counters
+ */
+static std::string pattern(size_t bytes) {
+    std::string expected;
+    for (uint32_t i = 0; expected.size() < bytes; i++) {
+        for (int b = 0; b < 4; b++) {
+            expected.push_back((char)(i >> (8 * b)));
+        }
+    }
+    expected.resize(bytes);
+    return expected;
+}
+
+void test_send_stream_limits_each_call(void) {
+    AsyncWebServerRequest request;
+    size_t calls = 0;
+
+    sendStream(&request, "text/plain", [&calls](size_t offset, uint8_t* out, size_t len) -> size_t {
+        calls++;
+        TEST_ASSERT_LESS_OR_EQUAL(STREAM_CHUNK_SIZE, len);
+        size_t n = min(len, (size_t)5000 - offset);
+        memset(out, 'x', n);
+        return n;
+    });
+
+    AsyncWebServerResponse* response = request.getResponse();
+    TEST_ASSERT_EQUAL_STRING("no-store", response->headers["Cache-Control"].c_str());
+
+    size_t largest;
+    TEST_ASSERT_EQUAL_size_t(5000, drain(response, &largest).size());
+    TEST_ASSERT_EQUAL_size_t(STREAM_CHUNK_SIZE, largest);
+    TEST_ASSERT_GREATER_OR_EQUAL(5, calls);
+}
+
+void test_selftest_payload_matches_script(void) {
+    AsyncWebServerRequest request("/selftest/stream");
+    request.params["kb"] = "300";
+    TEST_ASSERT_TRUE(server.handle(&request));
+
+    size_t largest;
+    std::string body = drain(request.getResponse(), &largest);
+    std::string expected = pattern(300 * 1024);
+    TEST_ASSERT_EQUAL_size_t(expected.size(), body.size());
+    TEST_ASSERT_TRUE(body == expected);
+    TEST_ASSERT_LESS_OR_EQUAL(STREAM_CHUNK_SIZE, largest);
+
+    // The finished run is reported with the heap seen while sending
+    AsyncWebServerRequest result("/selftest/stream/result");
+    TEST_ASSERT_TRUE(server.handle(&result));
+    const std::string& json = result.getResponse()->body;
+    TEST_ASSERT_TRUE(json.find("\"bytes\":307200,") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"heapBefore\":200000,") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"heapMin\":183") != std::string::npos);
+}
+
+void test_selftest_rejects_bad_size(void) {
+    AsyncWebServerRequest request("/selftest/stream");
+    request.params["kb"] = "0";
+    server.handle(&request);
+    TEST_ASSERT_EQUAL(400, request.getResponse()->code());
+
+    AsyncWebServerRequest huge("/selftest/stream");
+    huge.params["kb"] = "4097";
+    server.handle(&huge);
+    TEST_ASSERT_EQUAL(400, huge.getResponse()->code());
+}
+
+void test_selftest_streams_files(void) {
+    std::string content = pattern(10000);
+    LittleFS.add("/history.bin", content);
+
+    AsyncWebServerRequest request("/selftest/stream");
+    request.params["file"] = "/history.bin";
+    server.handle(&request);
+
+    size_t largest;
+    TEST_ASSERT_TRUE(drain(request.getResponse(), &largest) == content);
+
+    AsyncWebServerRequest missing("/selftest/stream");
+    missing.params["file"] = "/nope";
+    server.handle(&missing);
+    TEST_ASSERT_EQUAL(404, missing.getResponse()->code());
+}
+
+int main(void) {
+    selftest.begin(server);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_send_stream_limits_each_call);
+    RUN_TEST(test_selftest_payload_matches_script);
+    RUN_TEST(test_selftest_rejects_bad_size);
+    RUN_TEST(test_selftest_streams_files);
+    return UNITY_END();
+}
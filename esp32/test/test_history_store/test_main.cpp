@@ -0,0 +1,180 @@
+/**
+ * @file test_main.cpp
+ * @brief Native tests for the tiered history in HistoryStore.h
+ * @author Yahya
+ *
+ * Run with: pio test -e native -f test_history_store
+ */
+
+#include <unity.h>
+#include <vector>
+#include "HistoryStore.h"
+
+static HistoryStore* history;
+
+void setUp(void) {
+    history = new HistoryStore();
+    TEST_ASSERT_TRUE(history->begin());
+}
+
+void tearDown(void) {
+    delete history;
+}
+
+/**
+ * @brief Sample recorded at a second: its temperature is sec / 100
+ */
+static void recordAt(uint32_t sec) {
+    const int16_t values[HISTORY_FIELDS] = {(int16_t)(sec / 100), 5000, 100};
+    history->record(values, sec);
+}
+
+/**
+ * @brief One tier of a parsed export, records in time order
+ */
+struct ParsedTier {
+    uint16_t period;
+    uint32_t newest;
+    std::vector<std::vector<int16_t>> records;
+
+    uint32_t timeOf(size_t i) const {
+        return newest - (uint32_t)(records.size() - 1 - i) * period;
+    }
+};
+
+static std::vector<ParsedTier> parse(void) {
+    HistoryStore::View v = history->view();
+    std::vector<uint8_t> stream(history->exportSize(v));
+    size_t offset = 0;
+    size_t n;
+
+    while ((n = history->exportSlice(v, offset, stream.data() + offset, 1000)) > 0) {
+        offset += n;
+    }
+    TEST_ASSERT_EQUAL(stream.size(), offset);
+
+    std::vector<ParsedTier> tiers(3);
+    size_t at = HISTORY_HEADER_SIZE;
+    for (int t = 0; t < 3; t++) {
+        uint16_t count;
+        memcpy(&count, &stream[12 + t * 8], 2);
+        memcpy(&tiers[t].period, &stream[14 + t * 8], 2);
+        memcpy(&tiers[t].newest, &stream[16 + t * 8], 4);
+
+        size_t words = t == 0 ? HISTORY_FIELDS : HISTORY_FIELDS * 3;
+        for (uint16_t i = 0; i < count; i++) {
+            std::vector<int16_t> record(words);
+            memcpy(record.data(), &stream[at], words * 2);
+            at += words * 2;
+            tiers[t].records.push_back(record);
+        }
+    }
+    return tiers;
+}
+
+/**
+ * @brief Every record sits at the time the client derives for it
+ *
+ * Temperature min and max of a rollup are the first and last recorded
+ * seconds of its period, so a record drawn at the wrong time shows up
+ * as a mismatch.
+ */
+static void checkTimes(const std::vector<ParsedTier>& tiers, bool (*recorded)(uint32_t)) {
+    for (size_t i = 0; i < tiers[0].records.size(); i++) {
+        uint32_t sec = tiers[0].timeOf(i);
+        int16_t expected = recorded(sec) ? (int16_t)(sec / 100) : HISTORY_INVALID;
+        TEST_ASSERT_EQUAL_INT16(expected, tiers[0].records[i][HISTORY_TEMPERATURE]);
+    }
+
+    for (int t = 1; t < 3; t++) {
+        for (size_t i = 0; i < tiers[t].records.size(); i++) {
+            uint32_t end = tiers[t].timeOf(i);
+            int32_t lo = -1, hi = -1;
+            for (uint32_t sec = end + 1 - tiers[t].period; sec <= end; sec++) {
+                if (recorded(sec)) {
+                    if (lo < 0) lo = sec / 100;
+                    hi = sec / 100;
+                }
+            }
+            TEST_ASSERT_EQUAL_INT16(lo < 0 ? HISTORY_INVALID : lo, tiers[t].records[i][0]);
+            TEST_ASSERT_EQUAL_INT16(hi < 0 ? HISTORY_INVALID : hi, tiers[t].records[i][2]);
+        }
+    }
+}
+
+static bool shortGapRecorded(uint32_t sec) {
+    return sec < 100 || sec >= 130;
+}
+
+/**
+ * @brief Gaps up to HISTORY_MAX_GAP are filled second by second
+ */
+void test_short_gap_filled(void) {
+    for (uint32_t sec = 0; sec < 1300; sec++) {
+        if (shortGapRecorded(sec)) {
+            recordAt(sec);
+        }
+    }
+    std::vector<ParsedTier> tiers = parse();
+
+    TEST_ASSERT_EQUAL(1300, tiers[0].records.size());
+    TEST_ASSERT_EQUAL(1299, tiers[0].newest);
+    TEST_ASSERT_EQUAL(21, tiers[1].records.size());
+    TEST_ASSERT_EQUAL(2, tiers[2].records.size());
+    checkTimes(tiers, shortGapRecorded);
+}
+
+static bool longGapRecorded(uint32_t sec) {
+    return sec < 250 || (sec >= 1735 && sec < 2000);
+}
+
+/**
+ * @brief A longer stall keeps the fixed period in every tier
+ */
+void test_long_gap_keeps_times(void) {
+    for (uint32_t sec = 0; sec < 2000; sec++) {
+        if (longGapRecorded(sec)) {
+            recordAt(sec);
+        }
+    }
+    std::vector<ParsedTier> tiers = parse();
+
+    TEST_ASSERT_EQUAL(2000, tiers[0].records.size());
+    TEST_ASSERT_EQUAL(1999, tiers[0].newest);
+    TEST_ASSERT_EQUAL(33, tiers[1].records.size());
+    TEST_ASSERT_EQUAL(1979, tiers[1].newest);
+    TEST_ASSERT_EQUAL(3, tiers[2].records.size());
+    TEST_ASSERT_EQUAL(1799, tiers[2].newest);
+    checkTimes(tiers, longGapRecorded);
+}
+
+static bool hugeGapRecorded(uint32_t sec) {
+    return sec < 700 || sec >= 2000000;
+}
+
+/**
+ * @brief A stall longer than every ring leaves only invalid records before it
+ */
+void test_huge_gap_overwrites_rings(void) {
+    for (uint32_t sec = 0; sec < 700; sec++) {
+        recordAt(sec);
+    }
+    for (uint32_t sec = 2000000; sec < 2000100; sec++) {
+        recordAt(sec);
+    }
+    std::vector<ParsedTier> tiers = parse();
+
+    TEST_ASSERT_EQUAL(HISTORY_RAW_LEN, tiers[0].records.size());
+    TEST_ASSERT_EQUAL(2000099, tiers[0].newest);
+    TEST_ASSERT_EQUAL(HISTORY_MINUTE_LEN, tiers[1].records.size());
+    TEST_ASSERT_EQUAL(HISTORY_TENMIN_LEN, tiers[2].records.size());
+    checkTimes(tiers, hugeGapRecorded);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_short_gap_filled);
+    RUN_TEST(test_long_gap_keeps_times);
+    RUN_TEST(test_huge_gap_overwrites_rings);
+    return UNITY_END();
+}
@@ -0,0 +1,174 @@
+/**
+ * @file test_main.cpp
+ * @brief Native tests for the light channel filter chain in Lys.h
+ * @author Yahya
+ *
+ * Run with: pio test -e native -f test_light_filter
+ */
+
+#include <unity.h>
+#include "Lys.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+/**
+ * @brief 16 raw samples make one decimated sample, their mean in Q4
+ */
+void test_decimator_emits_mean_every_16_samples(void) {
+    LightDecimator decimator;
+    uint16_t out = 0;
+
+    for (int i = 0; i < 15; i++) {
+        TEST_ASSERT_FALSE(decimator.push(i < 8 ? 100 : 101, out));
+    }
+    TEST_ASSERT_TRUE(decimator.push(101, out));
+    TEST_ASSERT_EQUAL_UINT16(1608, out);    // 100.5 in Q4: the extra resolution survives
+
+    // The next block starts from an empty sum
+    for (int i = 0; i < 15; i++) {
+        TEST_ASSERT_FALSE(decimator.push(ADC_MAX_VALUE, out));
+    }
+    TEST_ASSERT_TRUE(decimator.push(ADC_MAX_VALUE, out));
+    TEST_ASSERT_EQUAL_UINT16(ADC_MAX_VALUE << LIGHT_FRAC_BITS, out);
+}
+
+/**
+ * @brief With less oversampling than fraction bits the mean is shifted up
+ */
+void test_decimator_short_window(void) {
+    LightDecimator decimator(2);
+    uint16_t out = 0;
+
+    TEST_ASSERT_FALSE(decimator.push(10, out));
+    TEST_ASSERT_FALSE(decimator.push(10, out));
+    TEST_ASSERT_FALSE(decimator.push(11, out));
+    TEST_ASSERT_TRUE(decimator.push(11, out));
+    TEST_ASSERT_EQUAL_UINT16(168, out);     // 10.5 in Q4
+}
+
+/**
+ * @brief Isolated spikes up to (N-1)/2 samples long never reach the output
+ */
+void test_median_rejects_spikes(void) {
+    LightMedian<5> median;
+
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_UINT16(1000, median.push(1000));
+    }
+    TEST_ASSERT_EQUAL_UINT16(1000, median.push(60000));
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_UINT16(1000, median.push(1000));
+    }
+    TEST_ASSERT_EQUAL_UINT16(1000, median.push(0));
+    TEST_ASSERT_EQUAL_UINT16(1000, median.push(60000));
+    TEST_ASSERT_EQUAL_UINT16(1000, median.push(1000));
+    TEST_ASSERT_EQUAL_UINT16(1000, median.push(1000));
+}
+
+/**
+ * @brief A lasting step passes once it holds the majority of the window
+ */
+void test_median_passes_steps(void) {
+    LightMedian<5> median;
+
+    for (int i = 0; i < 5; i++) {
+        median.push(1000);
+    }
+    TEST_ASSERT_EQUAL_UINT16(1000, median.push(2000));
+    TEST_ASSERT_EQUAL_UINT16(1000, median.push(2000));
+    TEST_ASSERT_EQUAL_UINT16(2000, median.push(2000));
+}
+
+/**
+ * @brief The median of a partly filled window only uses the samples seen
+ */
+void test_median_partial_window(void) {
+    LightMedian<5> median;
+
+    TEST_ASSERT_EQUAL_UINT16(500, median.push(500));
+    TEST_ASSERT_EQUAL_UINT16(700, median.push(700));    // Upper of two
+    TEST_ASSERT_EQUAL_UINT16(600, median.push(600));
+}
+
+/**
+ * @brief Step response of the IIR: 1 - 1/e after one time constant, then settled
+ */
+void test_low_pass_step_response(void) {
+    LightLowPass lowPass;
+    lowPass.configure(200, 160);            // 32 samples: k = 5
+
+    const uint16_t low = 1000 << LIGHT_FRAC_BITS;
+    const uint16_t high = 2000 << LIGHT_FRAC_BITS;
+    const uint16_t step = high - low;
+
+    TEST_ASSERT_EQUAL_UINT16(low, lowPass.push(low));   // Starts settled
+    TEST_ASSERT_EQUAL_UINT16(low, lowPass.push(low));
+
+    uint16_t previous = low;
+    uint16_t y = low;
+    for (int i = 0; i < 32; i++) {
+        y = lowPass.push(high);
+        TEST_ASSERT_GREATER_OR_EQUAL(previous, y);     // Monotonic, no overshoot
+        TEST_ASSERT_LESS_OR_EQUAL(high, y);
+        previous = y;
+    }
+    // 1 - (31/32)^32 = 63.8% of the step
+    TEST_ASSERT_UINT16_WITHIN(step / 100, low + step * 638 / 1000, y);
+
+    for (int i = 0; i < 1000; i++) {
+        y = lowPass.push(high);
+    }
+    TEST_ASSERT_EQUAL_UINT16(high, y);      // Guard bits keep it from stalling short
+}
+
+/**
+ * @brief The time constant is rounded up to a power of two samples
+ */
+void test_low_pass_configure(void) {
+    LightLowPass fast;
+    LightLowPass slow;
+    fast.configure(10, 100);                // 1 sample: passes straight through
+    slow.configure(200, 100);               // 20 samples: k = 5
+
+    fast.push(0);
+    TEST_ASSERT_EQUAL_UINT16(1600, fast.push(1600));
+
+    slow.push(0);
+    TEST_ASSERT_EQUAL_UINT16(50, slow.push(1600));     // 1600 / 32
+}
+
+/**
+ * @brief The full chain holds a constant reading exactly and ignores a spike
+ */
+void test_filter_chain(void) {
+    LightFilter filter;
+    filter.configure(16 * 100);
+
+    int outputs = 0;
+    for (int i = 0; i < 16 * 10; i++) {
+        outputs += filter.push(2048);
+    }
+    TEST_ASSERT_EQUAL(10, outputs);
+    TEST_ASSERT_EQUAL_UINT16(2048, filter.value());
+    TEST_ASSERT_EQUAL_UINT16(2048 << LIGHT_FRAC_BITS, filter.valueQ4());
+
+    // A 16-sample burst at full scale is one decimated spike
+    for (int i = 0; i < 16; i++) {
+        filter.push(ADC_MAX_VALUE);
+    }
+    TEST_ASSERT_EQUAL_UINT16(2048, filter.value());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_decimator_emits_mean_every_16_samples);
+    RUN_TEST(test_decimator_short_window);
+    RUN_TEST(test_median_rejects_spikes);
+    RUN_TEST(test_median_passes_steps);
+    RUN_TEST(test_median_partial_window);
+    RUN_TEST(test_low_pass_step_response);
+    RUN_TEST(test_low_pass_configure);
+    RUN_TEST(test_filter_chain);
+    return UNITY_END();
+}
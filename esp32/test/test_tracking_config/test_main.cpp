@@ -0,0 +1,199 @@
+/**
+ * @file test_main.cpp
+ * @brief Native tests for the tracking thresholds and their store
+ * @author Yahya
+ *
+ * Run with: pio test -e native -f test_tracking_config
+ */
+
+#include <unity.h>
+#include <thread>
+#include "TrackingConfig.h"
+
+static TrackingConfigStore store;
+
+void setUp(void) {
+    Preferences::clearAll();
+    store.apply(TrackingConfig(), false);
+}
+
+void tearDown(void) {}
+
+static const char* setText(TrackingConfig& config, const char* fields) {
+    char text[64];
+    snprintf(text, sizeof(text), "%s", fields);
+    return config.setFields(text) ? nullptr : "rejected";
+}
+
+void test_defaults_are_valid(void) {
+    TrackingConfig config;
+    TEST_ASSERT_NULL(config.validate());
+    TEST_ASSERT_EQUAL_UINT16(SKY_OVERCAST_ENTER, config.minIrradiance);
+    TEST_ASSERT_EQUAL_UINT16(TRACKING_SATURATION_OFF, config.saturation);
+}
+
+void test_validate_ranges(void) {
+    TrackingConfig config;
+
+    config.deadbandPercent = TRACKING_DEADBAND_MAX + 1;
+    TEST_ASSERT_NOT_NULL(config.validate());
+    config.deadbandPercent = TRACKING_DEADBAND_MAX;
+    TEST_ASSERT_NULL(config.validate());
+
+    config.minIrradiance = SKY_NIGHT_EXIT;
+    TEST_ASSERT_NOT_NULL(config.validate());
+    config.minIrradiance = TRACKING_MIN_IRRADIANCE_MAX + 1;
+    TEST_ASSERT_NOT_NULL(config.validate());
+    config.minIrradiance = SKY_OVERCAST_ENTER;
+
+    config.saturation = 0;
+    TEST_ASSERT_NOT_NULL(config.validate());
+    config.saturation = TRACKING_SATURATION_OFF + 1;
+    TEST_ASSERT_NOT_NULL(config.validate());
+}
+
+void test_validate_rejects_untrackable_combination(void) {
+    TrackingConfig config;
+
+    // Four saturated channels must still clear the overcast exit level
+    config.minIrradiance = 2000;
+    config.saturation = (2000 + SKY_OVERCAST_HYSTERESIS) / LIGHT_CHANNELS;
+    TEST_ASSERT_NOT_NULL(config.validate());
+    config.saturation++;
+    TEST_ASSERT_NULL(config.validate());
+}
+
+void test_set_fields(void) {
+    TrackingConfig config;
+
+    TEST_ASSERT_NULL(setText(config, "setpoint=5&minLimit=1500"));
+    TEST_ASSERT_EQUAL_UINT16(5, config.deadbandPercent);
+    TEST_ASSERT_EQUAL_UINT16(1500, config.minIrradiance);
+    TEST_ASSERT_EQUAL_UINT16(TRACKING_SATURATION_OFF, config.saturation);
+
+    TEST_ASSERT_NULL(setText(config, "maxLimit=&setpoint=7"));    // Empty keeps
+    TEST_ASSERT_EQUAL_UINT16(TRACKING_SATURATION_OFF, config.saturation);
+    TEST_ASSERT_EQUAL_UINT16(7, config.deadbandPercent);
+
+    TEST_ASSERT_NOT_NULL(setText(config, "deadband=5"));
+    TEST_ASSERT_NOT_NULL(setText(config, "setpoint"));
+    TEST_ASSERT_NOT_NULL(setText(config, "setpoint=5x"));
+    TEST_ASSERT_NOT_NULL(setText(config, "setpoint=-1"));
+    TEST_ASSERT_NOT_NULL(setText(config, "minLimit=65536"));
+}
+
+void test_deadband_and_saturation(void) {
+    TrackingConfig config;
+    config.deadbandPercent = 10;                // 409 in Q12
+
+    SunError inside = {400, -400, 3000, 4096};
+    SunError outside = {400, -410, 3000, 4096};
+    TEST_ASSERT_TRUE(config.withinDeadband(inside));
+    TEST_ASSERT_FALSE(config.withinDeadband(outside));
+
+    const uint16_t level[LIGHT_CHANNELS] = {1000, 3999, 1000, 1000};
+    TEST_ASSERT_FALSE(config.saturated(level));     // Disabled by default
+    config.saturation = 3999;
+    TEST_ASSERT_TRUE(config.saturated(level));
+}
+
+void test_classifier_follows_min_limit(void) {
+    SkyClassifier sky;
+    SunError dim = {0, 0, 1400, 4096};
+
+    sky.setOvercastThreshold(1500);
+    sky.update(dim, 0);
+    TEST_ASSERT_TRUE(sky.update(dim, SKY_HOLD_MS));
+    TEST_ASSERT_EQUAL(SKY_OVERCAST, sky.condition());
+
+    // Leaving needs the threshold plus the hysteresis
+    SunError brighter = {0, 0, 1500 + SKY_OVERCAST_HYSTERESIS - 1, 4096};
+    sky.update(brighter, SKY_HOLD_MS + 1);
+    TEST_ASSERT_FALSE(sky.update(brighter, 3 * SKY_HOLD_MS));
+    TEST_ASSERT_EQUAL(SKY_OVERCAST, sky.condition());
+}
+
+void test_classifier_restored_after_sleep(void) {
+    SkyClassifier sky;
+    SunError dawn = {600, 0, 6000, 4096};    // Clear sun off to one side
+
+    // Woken from night sleep: bright readings must hold before tracking starts
+    sky.restore(SKY_NIGHT);
+    TEST_ASSERT_FALSE(sky.tracking());
+    TEST_ASSERT_FALSE(sky.update(dawn, 0));
+    TEST_ASSERT_FALSE(sky.update(dawn, SKY_HOLD_MS - 1));
+    TEST_ASSERT_TRUE(sky.update(dawn, SKY_HOLD_MS));
+    TEST_ASSERT_TRUE(sky.tracking());
+}
+
+void test_apply_rejects_invalid_set(void) {
+    TrackingConfig config;
+    config.deadbandPercent = 99;
+
+    TEST_ASSERT_NOT_NULL(store.apply(config));
+    trackingConfig.latest(config);
+    TEST_ASSERT_EQUAL_UINT16(0, config.deadbandPercent);
+}
+
+void test_update_merges_into_active_set(void) {
+    TrackingConfig result;
+
+    TEST_ASSERT_NULL(store.update([](TrackingConfig& c) { return setText(c, "setpoint=5"); }));
+    TEST_ASSERT_NULL(store.update([](TrackingConfig& c) { return setText(c, "minLimit=1500"); }, &result));
+    TEST_ASSERT_EQUAL_UINT16(5, result.deadbandPercent);
+    TEST_ASSERT_EQUAL_UINT16(1500, result.minIrradiance);
+
+    // Stored as well as published
+    TrackingConfig loaded;
+    TEST_ASSERT_TRUE(store.load(loaded));
+    TEST_ASSERT_EQUAL_UINT16(5, loaded.deadbandPercent);
+    TEST_ASSERT_EQUAL_UINT16(1500, loaded.minIrradiance);
+}
+
+void test_failed_update_changes_nothing(void) {
+    TrackingConfig result;
+
+    TEST_ASSERT_NULL(store.update([](TrackingConfig& c) { return setText(c, "setpoint=5"); }));
+    TEST_ASSERT_NOT_NULL(store.update([](TrackingConfig& c) { return setText(c, "setpoint=9&minLimit=x"); }));
+    TEST_ASSERT_NOT_NULL(store.update([](TrackingConfig& c) { return setText(c, "setpoint=90"); }, &result));
+    TEST_ASSERT_EQUAL_UINT16(5, result.deadbandPercent);
+}
+
+void test_concurrent_updates_are_not_lost(void) {
+    const int rounds = 2000;
+
+    std::thread web([&] {
+        for (int i = 0; i < rounds; i++) {
+            store.update([i](TrackingConfig& c) { c.deadbandPercent = i % 50; return (const char*)nullptr; });
+        }
+    });
+    std::thread mqtt([&] {
+        for (int i = 0; i < rounds; i++) {
+            store.update([i](TrackingConfig& c) { c.minIrradiance = 1000 + i; return (const char*)nullptr; });
+        }
+    });
+    web.join();
+    mqtt.join();
+
+    // Each writer's last change survives the other's
+    TrackingConfig config;
+    trackingConfig.latest(config);
+    TEST_ASSERT_EQUAL_UINT16((rounds - 1) % 50, config.deadbandPercent);
+    TEST_ASSERT_EQUAL_UINT16(1000 + rounds - 1, config.minIrradiance);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_defaults_are_valid);
+    RUN_TEST(test_validate_ranges);
+    RUN_TEST(test_validate_rejects_untrackable_combination);
+    RUN_TEST(test_set_fields);
+    RUN_TEST(test_deadband_and_saturation);
+    RUN_TEST(test_classifier_follows_min_limit);
+    RUN_TEST(test_classifier_restored_after_sleep);
+    RUN_TEST(test_apply_rejects_invalid_set);
+    RUN_TEST(test_update_merges_into_active_set);
+    RUN_TEST(test_failed_update_changes_nothing);
+    RUN_TEST(test_concurrent_updates_are_not_lost);
+    return UNITY_END();
+}
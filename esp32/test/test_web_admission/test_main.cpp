@@ -0,0 +1,216 @@
+/**
+ * @file test_main.cpp
+ * @brief Native tests for web admission control through the WebMetrics middleware
+ * @author Yahya
+ *
+ * Run with: pio test -e native -f test_web_admission
+ */
+
+#include <unity.h>
+#include <deque>
+#include "WebMetrics.h"
+
+static AsyncWebSocket ws;
+static AsyncEventSource events;
+static WebAdmission* admission;
+static WebMetrics* metrics;
+static std::deque<AsyncWebServerRequest> requests;
+static uint32_t nextAddress;
+
+void setUp(void) {
+    stubMillis = 1000;
+    stubHeapFree = 200000;
+    ws.clients = 0;
+    events.clients = 0;
+    requests.clear();
+    nextAddress = 100;
+
+    admission = new WebAdmission();
+    metrics = new WebMetrics();
+    admission->begin(classifyRequest, ws, events);
+    metrics->setAdmission(*admission);
+}
+
+void tearDown(void) {
+    delete metrics;
+    delete admission;
+}
+
+/**
+ * @brief Open a request from its own address (or `address`) and return its status
+ */
+static int open(const char* url, AsyncWebServerRequest** out = nullptr, uint32_t address = 0) {
+    requests.emplace_back(url);
+    AsyncWebServerRequest& request = requests.back();
+    request.tcp.address = address ? address : nextAddress++;
+    if (out) {
+        *out = &request;
+    }
+
+    metrics->run(&request, [&request]() {
+        request.send(200, "text/plain", "ok");
+    });
+    return request.getResponse()->code();
+}
+
+static std::string retryAfter(AsyncWebServerRequest* request) {
+    return request->getResponse()->headers["Retry-After"];
+}
+
+/**
+ * @brief Class of a firmware route
+ */
+static WebClass classOf(const char* url) {
+    AsyncWebServerRequest request(url);
+    return admission->classify(&request, false);
+}
+
+void test_routes_classified(void) {
+    TEST_ASSERT_EQUAL(WEB_CLASS_CONTROL, classOf("/setpoint"));
+    TEST_ASSERT_EQUAL(WEB_CLASS_CONTROL, classOf("/api/state"));
+    TEST_ASSERT_EQUAL(WEB_CLASS_CONTROL, classOf("/calibrate/dark"));
+    TEST_ASSERT_EQUAL(WEB_CLASS_CONTROL, classOf("/calibrate/light"));
+
+    TEST_ASSERT_EQUAL(WEB_CLASS_BULK, classOf("/history"));
+    TEST_ASSERT_EQUAL(WEB_CLASS_BULK, classOf("/selftest/stream"));
+    TEST_ASSERT_EQUAL(WEB_CLASS_BULK, classOf("/selftest/stream/result"));
+
+    TEST_ASSERT_EQUAL(WEB_CLASS_NORMAL, classOf("/"));
+    TEST_ASSERT_EQUAL(WEB_CLASS_NORMAL, classOf("/app.js"));
+    TEST_ASSERT_EQUAL(WEB_CLASS_NORMAL, classOf("/temperature"));
+    TEST_ASSERT_EQUAL(WEB_CLASS_NORMAL, classOf("/metrics"));
+    TEST_ASSERT_EQUAL(WEB_CLASS_NORMAL, classOf("/history.bin"));
+}
+
+void test_bulk_limit_and_release(void) {
+    AsyncWebServerRequest* first;
+    AsyncWebServerRequest* refused;
+
+    TEST_ASSERT_EQUAL(200, open("/history", &first));
+    TEST_ASSERT_EQUAL(200, open("/selftest/stream"));
+    TEST_ASSERT_EQUAL(503, open("/history", &refused));
+    TEST_ASSERT_EQUAL_STRING("2", retryAfter(refused).c_str());
+    TEST_ASSERT_EQUAL_UINT32(1, admission->rejections(WEB_REJECT_BULK));
+
+    // Dashboard files are normal requests and load in parallel meanwhile
+    TEST_ASSERT_EQUAL(200, open("/style.css"));
+    TEST_ASSERT_EQUAL(200, open("/chart.js"));
+    TEST_ASSERT_EQUAL(200, open("/app.js"));
+
+    // A refused request holds no slot; a finished one gives its slot back
+    refused->disconnect();
+    TEST_ASSERT_EQUAL(503, open("/history"));
+    first->disconnect();
+    TEST_ASSERT_EQUAL(200, open("/history"));
+}
+
+void test_connection_limit_keeps_reserve_for_control(void) {
+    AsyncWebServerRequest* refused;
+
+    for (int i = 0; i < WEB_MAX_CONNECTIONS - WEB_CONTROL_RESERVE; i++) {
+        TEST_ASSERT_EQUAL(200, open("/temperature"));
+    }
+    // A refusal holds its connection until the client has read it
+    TEST_ASSERT_EQUAL(503, open("/temperature", &refused));
+    refused->disconnect();
+    TEST_ASSERT_EQUAL(503, open("/history", &refused));
+    refused->disconnect();
+
+    for (int i = 0; i < WEB_CONTROL_RESERVE; i++) {
+        TEST_ASSERT_EQUAL(200, open("/setpoint"));
+    }
+    TEST_ASSERT_EQUAL(503, open("/api/state"));
+    TEST_ASSERT_EQUAL_UINT32(3, admission->rejections(WEB_REJECT_CONNECTIONS));
+}
+
+void test_low_heap_passes_only_control(void) {
+    stubHeapFree = WEB_MIN_FREE_HEAP - 1;
+
+    TEST_ASSERT_EQUAL(503, open("/temperature"));
+    TEST_ASSERT_EQUAL(503, open("/history"));
+    TEST_ASSERT_EQUAL(200, open("/setpoint"));
+    TEST_ASSERT_EQUAL_UINT32(2, admission->rejections(WEB_REJECT_HEAP));
+}
+
+void test_stream_client_limits(void) {
+    AsyncWebServerRequest* upgrade;
+
+    ws.clients = WEB_MAX_WS_CLIENTS;
+    requests.emplace_back("/ws");
+    upgrade = &requests.back();
+    upgrade->headers["Upgrade"] = "websocket";
+    metrics->run(upgrade, []() {});
+    TEST_ASSERT_EQUAL(503, upgrade->getResponse()->code());
+    upgrade->disconnect();                          // Refused upgrades are plain responses
+
+    events.clients = WEB_MAX_SSE_CLIENTS - 1;
+    requests.emplace_back("/events");
+    upgrade = &requests.back();
+    upgrade->headers["Accept"] = "text/event-stream";
+    metrics->run(upgrade, []() {});
+    TEST_ASSERT_NULL(upgrade->getResponse());     // Handed to the event source
+    TEST_ASSERT_EQUAL_UINT16(0, metrics->openConnections());
+    TEST_ASSERT_EQUAL_UINT32(1, admission->rejections(WEB_REJECT_STREAMS));
+}
+
+void test_token_bucket(void) {
+    const uint32_t client = 7;
+    AsyncWebServerRequest* request;
+
+    // A fresh client has a full burst
+    for (int i = 0; i < WEB_RATE_BURST; i++) {
+        TEST_ASSERT_EQUAL(200, open("/temperature", &request, client));
+        request->disconnect();
+    }
+    TEST_ASSERT_EQUAL(429, open("/temperature", &request, client));
+    TEST_ASSERT_EQUAL_STRING("1", retryAfter(request).c_str());
+    request->disconnect();
+
+    // Other clients have their own buckets
+    TEST_ASSERT_EQUAL(200, open("/temperature"));
+
+    // One second refills WEB_RATE_PER_SEC tokens; bulk costs WEB_BULK_COST
+    stubMillis += 1000;
+    int admitted = 0;
+    for (int i = 0; i < WEB_RATE_PER_SEC; i++) {
+        if (open("/history", &request, client) == 200) {
+            admitted++;
+        }
+        request->disconnect();
+    }
+    TEST_ASSERT_EQUAL(WEB_RATE_PER_SEC / WEB_BULK_COST, admitted);
+    TEST_ASSERT_GREATER_OR_EQUAL(1, admission->rejections(WEB_REJECT_RATE));
+}
+
+void test_gauge_and_metrics_after_rejections(void) {
+    AsyncWebServerRequest* refused;
+    AsyncWebServerRequest* served;
+
+    open("/history", &served);
+    open("/history");
+    open("/history", &refused);
+    TEST_ASSERT_EQUAL_UINT16(3, metrics->openConnections());
+    for (AsyncWebServerRequest& request : requests) {
+        request.disconnect();
+    }
+    TEST_ASSERT_EQUAL_UINT16(0, metrics->openConnections());
+
+    WebMetrics::Cursor cursor;
+    uint8_t buffer[8192];
+    size_t n = metrics->render(cursor, buffer, sizeof(buffer));
+    std::string text((const char*)buffer, n);
+    TEST_ASSERT_TRUE(text.find("esp32_http_rejected_total{reason=\"bulk\"} 1\n") != std::string::npos);
+    TEST_ASSERT_TRUE(text.find("esp32_http_rejected_total{reason=\"rate\"} 0\n") != std::string::npos);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_routes_classified);
+    RUN_TEST(test_bulk_limit_and_release);
+    RUN_TEST(test_connection_limit_keeps_reserve_for_control);
+    RUN_TEST(test_low_heap_passes_only_control);
+    RUN_TEST(test_stream_client_limits);
+    RUN_TEST(test_token_bucket);
+    RUN_TEST(test_gauge_and_metrics_after_rejections);
+    return UNITY_END();
+}
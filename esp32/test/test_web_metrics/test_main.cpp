@@ -0,0 +1,166 @@
+/**
+ * @file test_main.cpp
+ * @brief Native tests for the web route instrumentation and /metrics renderer
+ * @author Yahya
+ *
+ * Run with: pio test -e native -f test_web_metrics
+ */
+
+#include <unity.h>
+#include "WebMetrics.h"
+
+void setUp(void) {
+    stubTimeUs = 0;
+    stubHeapFree = 200000;
+    stubTaskStacks = {{"loopTask", 812}, {"async_tcp", 2048}};
+}
+
+void tearDown(void) {}
+
+/**
+ * @brief Run a request through the middleware; the handler answers `code`
+ */
+static void serve(WebMetrics& metrics, AsyncWebServerRequest& request, int code, size_t written,
+                  int64_t handlerUs = 0, size_t heapTaken = 0) {
+    metrics.run(&request, [&]() {
+        stubTimeUs += handlerUs;
+        stubHeapFree -= heapTaken;
+        request.send(code, "text/plain", "");
+        request.getResponse()->setWritten(written);
+    });
+}
+
+/**
+ * @brief Whole /metrics text, rendered `chunk` bytes at a time
+ */
+static std::string scrape(const WebMetrics& metrics, size_t chunk) {
+    WebMetrics::Cursor cursor;
+    std::string text;
+    uint8_t buffer[4096];
+    size_t n;
+
+    while ((n = metrics.render(cursor, buffer, chunk)) > 0) {
+        TEST_ASSERT_LESS_OR_EQUAL(chunk, n);
+        text.append((const char*)buffer, n);
+    }
+    return text;
+}
+
+static bool contains(const std::string& text, const char* line) {
+    return text.find(line) != std::string::npos;
+}
+
+void test_counts_per_route(void) {
+    WebMetrics metrics;
+
+    for (int i = 0; i < 3; i++) {
+        AsyncWebServerRequest request("/api/state");
+        serve(metrics, request, 200, 321, 1500, 400);
+        request.disconnect();
+    }
+    AsyncWebServerRequest failed("/setpoint");
+    serve(metrics, failed, 400, 20, 9000);
+    failed.disconnect();
+
+    std::string text = scrape(metrics, 4096);
+    TEST_ASSERT_TRUE(contains(text, "esp32_http_requests_total{route=\"/api/state\"} 3\n"));
+    TEST_ASSERT_TRUE(contains(text, "esp32_http_errors_total{route=\"/api/state\"} 0\n"));
+    TEST_ASSERT_TRUE(contains(text, "esp32_http_errors_total{route=\"/setpoint\"} 1\n"));
+    TEST_ASSERT_TRUE(contains(text, "esp32_http_handler_seconds_total{route=\"/api/state\"} 0.004500\n"));
+    TEST_ASSERT_TRUE(contains(text, "esp32_http_handler_seconds_max{route=\"/setpoint\"} 0.009000\n"));
+    TEST_ASSERT_TRUE(contains(text, "esp32_http_response_bytes_total{route=\"/api/state\"} 963\n"));
+    TEST_ASSERT_TRUE(contains(text, "esp32_http_handler_heap_bytes{route=\"/api/state\"} 1200\n"));
+}
+
+void test_unknown_paths_share_other(void) {
+    WebMetrics metrics;
+
+    const char* const probes[] = {"/wp-login.php", "/.env", "/admin"};
+    for (const char* path : probes) {
+        AsyncWebServerRequest request(path);
+        serve(metrics, request, 404, 90);
+        request.disconnect();
+    }
+
+    std::string text = scrape(metrics, 4096);
+    TEST_ASSERT_FALSE(contains(text, "/wp-login.php"));
+    TEST_ASSERT_TRUE(contains(text, "esp32_http_requests_total{route=\"other\"} 3\n"));
+    TEST_ASSERT_TRUE(contains(text, "esp32_http_errors_total{route=\"other\"} 3\n"));
+}
+
+void test_route_table_is_bounded(void) {
+    WebMetrics metrics;
+    char path[16];
+
+    for (int i = 0; i < WEB_METRICS_ROUTES + 5; i++) {
+        snprintf(path, sizeof(path), "/r%d", i);
+        AsyncWebServerRequest request(path);
+        serve(metrics, request, 200, 1);
+        request.disconnect();
+    }
+
+    std::string text = scrape(metrics, 4096);
+    TEST_ASSERT_TRUE(contains(text, "esp32_http_requests_total{route=\"other\"} 5\n"));
+}
+
+void test_connection_gauge_returns_to_zero(void) {
+    WebMetrics metrics;
+    AsyncWebServerRequest first("/api/state");
+    AsyncWebServerRequest second("/history");
+
+    serve(metrics, first, 200, 10);
+    serve(metrics, second, 200, 10);
+    TEST_ASSERT_EQUAL_UINT16(2, metrics.openConnections());
+
+    // Upgrades live on in their own handler and are not open HTTP requests
+    AsyncWebServerRequest ws("/ws");
+    ws.headers["Upgrade"] = "websocket";
+    serve(metrics, ws, 101, 0);
+    AsyncWebServerRequest sse("/events");
+    sse.headers["Accept"] = "text/event-stream";
+    serve(metrics, sse, 200, 0);
+    TEST_ASSERT_EQUAL_UINT16(2, metrics.openConnections());
+
+    first.disconnect();
+    second.disconnect();
+    ws.disconnect();
+    sse.disconnect();
+    TEST_ASSERT_EQUAL_UINT16(0, metrics.openConnections());
+
+    std::string text = scrape(metrics, 4096);
+    TEST_ASSERT_TRUE(contains(text, "esp32_http_connections 0\n"));
+    TEST_ASSERT_TRUE(contains(text, "esp32_http_connections_max 2\n"));
+}
+
+void test_render_is_independent_of_chunk_size(void) {
+    WebMetrics metrics;
+    metrics.watchTask("loopTask");
+    metrics.watchTask("missing");
+    metrics.watchTask("async_tcp");
+
+    AsyncWebServerRequest request("/api/state");
+    serve(metrics, request, 200, 321, 1500);
+    request.disconnect();
+
+    std::string full = scrape(metrics, 4096);
+    TEST_ASSERT_EQUAL_STRING(full.c_str(), scrape(metrics, 1).c_str());
+    TEST_ASSERT_EQUAL_STRING(full.c_str(), scrape(metrics, 7).c_str());
+    TEST_ASSERT_EQUAL_STRING(full.c_str(), scrape(metrics, 64).c_str());
+
+    TEST_ASSERT_TRUE(contains(full, "# TYPE esp32_http_requests_total counter\n"));
+    TEST_ASSERT_TRUE(contains(full, "esp32_heap_free_bytes 200000\n"));
+    TEST_ASSERT_TRUE(contains(full, "esp32_task_stack_high_water_bytes{task=\"loopTask\"} 812\n"));
+    TEST_ASSERT_TRUE(contains(full, "esp32_task_stack_high_water_bytes{task=\"async_tcp\"} 2048\n"));
+    TEST_ASSERT_FALSE(contains(full, "missing"));
+    TEST_ASSERT_EQUAL('\n', full.back());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_counts_per_route);
+    RUN_TEST(test_unknown_paths_share_other);
+    RUN_TEST(test_route_table_is_bounded);
+    RUN_TEST(test_connection_gauge_returns_to_zero);
+    RUN_TEST(test_render_is_independent_of_chunk_size);
+    return UNITY_END();
+}
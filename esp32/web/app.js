@@ -0,0 +1,234 @@
+var combinedChart = new LineChart('chart-combined', {
+    title: 'Temperature and Humidity Over Time',
+    axes: [
+        { title: 'Temperature (\u00b0C)' },   // Left
+        { title: 'Humidity (%)' }              // Right
+    ],
+    series: [
+        { name: 'Temperature', color: '#059e8a', axis: 0 },
+        { name: 'Humidity', color: '#1f78b4', axis: 1 }
+    ]
+});
+
+var lightChart = new LineChart('chart-light', {
+    title: 'Light Sensors',
+    axes: [{ title: 'ADC', min: 0, max: 4095 }],
+    series: [
+        { name: 'Left', color: '#2f7ed8' },
+        { name: 'Right', color: '#0d233a' },
+        { name: 'Up', color: '#8bbc21' },
+        { name: 'Down', color: '#910000' }
+    ]
+});
+
+var maxPoints = 7000;       // Temperature/humidity: a week of history plus live points
+var maxLightPoints = 600;   // Light, one per frame
+var lastEnvPoint = 0;
+var DIRS = ["Venstre", "H\u00f8jre", "Op", "Ned"];
+var SKIES = ["clear", "diffuse", "overcast", "night"];
+
+function update(d, now) {
+    if (now - lastEnvPoint >= 1000) {
+        lastEnvPoint = now;
+        if (d.temp !== null) {
+            document.getElementById("temperature").innerHTML = d.temp.toFixed(2);
+            combinedChart.addPoint(0, [now, d.temp], maxPoints);
+        }
+        if (d.hum !== null) {
+            document.getElementById("humidity").innerHTML = d.hum.toFixed(2);
+            combinedChart.addPoint(1, [now, d.hum], maxPoints);
+        }
+        combinedChart.redraw();
+    }
+
+    for (var i = 0; i < 4; i++) {
+        lightChart.addPoint(i, [now, d.light[i]], maxLightPoints);
+    }
+    lightChart.redraw();
+
+    document.getElementById("direction").textContent = d.dir;
+    document.getElementById("sky").textContent = d.sky;
+    document.getElementById("lightL").textContent = d.light[0];
+    document.getElementById("lightR").textContent = d.light[1];
+    document.getElementById("lightU").textContent = d.light[2];
+    document.getElementById("lightD").textContent = d.light[3];
+}
+
+// 24-byte little-endian frame, see TelemetryFrame in Telemetry.h
+function decodeFrame(buffer) {
+    var v = new DataView(buffer);
+    if (buffer.byteLength < 24 || v.getUint8(0) !== 1) {
+        return null;
+    }
+    var envValid = (v.getUint8(3) & 1) !== 0;
+    return {
+        t: v.getUint32(4, true),
+        dir: DIRS[v.getUint8(1)],
+        sky: SKIES[v.getUint8(2)] || "unknown",
+        light: [v.getUint16(8, true), v.getUint16(10, true), v.getUint16(12, true), v.getUint16(14, true)],
+        temp: envValid ? v.getInt16(16, true) / 100 : null,
+        hum: envValid ? v.getInt16(18, true) / 100 : null,
+        az: v.getInt16(20, true),
+        el: v.getInt16(22, true)
+    };
+}
+
+function showOffline() {
+    document.getElementById("temperature").innerHTML = "Offline";
+    document.getElementById("humidity").innerHTML = "Offline";
+}
+
+// Server-Sent Events: one shared push per sample, used when WebSocket is unavailable
+var source = null;
+function startEvents() {
+    if (source) {
+        return;
+    }
+    source = new EventSource('/events');
+    source.addEventListener('telemetry', function (e) {
+        update(JSON.parse(e.data), (new Date()).getTime());
+    }, false);
+    source.addEventListener('error', showOffline, false);
+}
+
+// Binary WebSocket stream at 10 Hz is preferred
+function startSocket() {
+    var ws = new WebSocket((location.protocol === 'https:' ? 'wss://' : 'ws://') + location.host + '/ws');
+    ws.binaryType = 'arraybuffer';
+    ws.onopen = function () {
+        if (source) {
+            source.close();
+            source = null;
+        }
+    };
+    ws.onmessage = function (e) {
+        var d = decodeFrame(e.data);
+        if (d) {
+            update(d, (new Date()).getTime());
+        }
+    };
+    ws.onclose = function () {
+        startEvents();
+        setTimeout(startSocket, 5000);
+    };
+}
+
+// Binary history export, see HistoryStore.h. Coarse tiers only fill in
+// the time before the next finer tier begins, so nothing is drawn twice.
+function loadHistory(buffer) {
+    var v = new DataView(buffer);
+    if (buffer.byteLength < 36 || v.getUint8(4) !== 1) {
+        return;
+    }
+    var fields = v.getUint8(5);
+    var nowSec = v.getUint32(8, true);
+    var now = (new Date()).getTime();
+    var tiers = [];
+    var offset = 36;
+
+    for (var t = 0; t < 3; t++) {
+        var tier = {
+            count: v.getUint16(12 + t * 8, true),
+            period: v.getUint16(14 + t * 8, true),
+            newest: v.getUint32(16 + t * 8, true),
+            words: t === 0 ? fields : fields * 3,
+            offset: offset
+        };
+        tier.oldest = tier.newest - (tier.count - 1) * tier.period;
+        offset += tier.count * tier.words * 2;
+        tiers.push(tier);
+    }
+
+    var temp = [], hum = [];
+    var cutoff = Infinity;
+    for (var t = 0; t < 3; t++) {
+        var tier = tiers[t];
+        var avg = t === 0 ? 0 : 1;  // Rollups store min, avg, max per field
+        var points = [];
+        for (var i = 0; i < tier.count; i++) {
+            var sec = tier.oldest + i * tier.period;
+            if (sec >= cutoff) {
+                break;
+            }
+            var base = tier.offset + i * tier.words * 2;
+            var step = t === 0 ? 2 : 6;
+            var x = now - (nowSec - sec) * 1000;
+            var tv = v.getInt16(base + avg * 2, true);
+            var hv = v.getInt16(base + step + avg * 2, true);
+            points.push([x, tv === -32768 ? null : tv / 100, hv === -32768 ? null : hv / 100]);
+        }
+        if (tier.count > 0) {
+            cutoff = Math.min(cutoff, tier.oldest);
+        }
+        for (var j = points.length - 1; j >= 0; j--) {
+            temp.unshift([points[j][0], points[j][1]]);
+            hum.unshift([points[j][0], points[j][2]]);
+        }
+    }
+
+    combinedChart.setData(0, temp.concat(combinedChart.getData(0)));
+    combinedChart.setData(1, hum.concat(combinedChart.getData(1)));
+    combinedChart.redraw();
+}
+
+// A busy ESP32 answers 503/429 with Retry-After; wait that long and try again
+function fetchRetry(url, attempts) {
+    return fetch(url).then(function (response) {
+        if ((response.status === 503 || response.status === 429) && attempts > 1) {
+            var seconds = parseInt(response.headers.get('Retry-After'), 10) || 2;
+            return new Promise(function (resolve) { setTimeout(resolve, seconds * 1000); })
+                .then(function () { return fetchRetry(url, attempts - 1); });
+        }
+        return response;
+    });
+}
+
+fetchRetry('/history', 5)
+    .then(function (response) {
+        if (!response.ok) {
+            throw new Error(response.status);
+        }
+        return response.arrayBuffer();
+    })
+    .then(loadHistory)
+    .catch(function () {});
+
+if ('WebSocket' in window) {
+    startSocket();
+} else {
+    startEvents();
+}
+
+document.getElementById("setpointForm").addEventListener("submit", function (event) {
+    event.preventDefault();
+
+    var setpoint = document.getElementById("setpointInput").value;
+    var maxLimit = document.getElementById("maxLimitInput").value;
+    var minLimit = document.getElementById("minLimitInput").value;
+
+    var requestData = "setpoint=" + encodeURIComponent(setpoint) +
+                      "&maxLimit=" + encodeURIComponent(maxLimit) +
+                      "&minLimit=" + encodeURIComponent(minLimit);
+
+    fetch("/setpoint", {
+        method: "POST",
+        headers: {
+            "Content-Type": "application/x-www-form-urlencoded"
+        },
+        body: requestData 
+    })
+    .then(response => response.text().then(data => {
+        document.getElementById("setpointMessage").textContent =
+            (response.ok ? "Setpoint successfully sent to server: " : "Setpoint rejected: ") + data;
+    }));
+});
+
+// Show the thresholds currently in use
+fetchRetry("/setpoint", 5)
+    .then(response => response.json())
+    .then(config => {
+        document.getElementById("setpointInput").value = config.setpoint;
+        document.getElementById("maxLimitInput").value = config.maxLimit;
+        document.getElementById("minLimitInput").value = config.minLimit;
+    })
+    .catch(function () {});
@@ -0,0 +1,166 @@
+/*
+ * Minimal canvas line chart for the solar tracker dashboard.
+ *
+ * Served from the ESP32 itself so the dashboard works without internet
+ * access. Supports time-based x values, one or two y axes, null gaps and
+ * a bounded number of points per series.
+ */
+(function (global) {
+    'use strict';
+
+    var PAD_LEFT = 48, PAD_RIGHT = 48, PAD_TOP = 28, PAD_BOTTOM = 24;
+
+    function LineChart(id, options) {
+        var container = document.getElementById(id);
+        this.canvas = document.createElement('canvas');
+        container.appendChild(this.canvas);
+        this.ctx = this.canvas.getContext('2d');
+        this.title = options.title || '';
+        this.axes = options.axes || [{}];
+        this.series = options.series.map(function (s) {
+            return { name: s.name, color: s.color, axis: s.axis || 0, data: [] };
+        });
+        this.pending = false;
+
+        var self = this;
+        window.addEventListener('resize', function () { self.redraw(); });
+        this.redraw();
+    }
+
+    LineChart.prototype.addPoint = function (index, point, limit) {
+        var data = this.series[index].data;
+        data.push(point);
+        if (data.length > limit) {
+            data.splice(0, data.length - limit);
+        }
+    };
+
+    LineChart.prototype.setData = function (index, points) {
+        this.series[index].data = points;
+    };
+
+    LineChart.prototype.getData = function (index) {
+        return this.series[index].data;
+    };
+
+    // Coalesce redraws to one per animation frame
+    LineChart.prototype.redraw = function () {
+        if (this.pending) {
+            return;
+        }
+        this.pending = true;
+        var self = this;
+        window.requestAnimationFrame(function () {
+            self.pending = false;
+            self.draw();
+        });
+    };
+
+    LineChart.prototype.range = function (axis) {
+        var cfg = this.axes[axis];
+        var lo = Infinity, hi = -Infinity;
+        this.series.forEach(function (s) {
+            if (s.axis !== axis) {
+                return;
+            }
+            s.data.forEach(function (p) {
+                if (p[1] !== null) {
+                    lo = Math.min(lo, p[1]);
+                    hi = Math.max(hi, p[1]);
+                }
+            });
+        });
+        if (cfg.min !== undefined) lo = cfg.min;
+        if (cfg.max !== undefined) hi = cfg.max;
+        if (lo === Infinity) { lo = 0; hi = 1; }
+        if (hi - lo < 1e-6) { lo -= 1; hi += 1; }
+        return [lo, hi];
+    };
+
+    LineChart.prototype.draw = function () {
+        var ratio = window.devicePixelRatio || 1;
+        var width = this.canvas.parentNode.clientWidth;
+        var height = this.canvas.parentNode.clientHeight;
+        this.canvas.width = width * ratio;
+        this.canvas.height = height * ratio;
+        this.canvas.style.width = width + 'px';
+        this.canvas.style.height = height + 'px';
+
+        var ctx = this.ctx;
+        ctx.setTransform(ratio, 0, 0, ratio, 0, 0);
+        ctx.clearRect(0, 0, width, height);
+        ctx.font = '11px Arial';
+
+        var plotW = width - PAD_LEFT - PAD_RIGHT;
+        var plotH = height - PAD_TOP - PAD_BOTTOM;
+
+        var xMin = Infinity, xMax = -Infinity;
+        this.series.forEach(function (s) {
+            if (s.data.length) {
+                xMin = Math.min(xMin, s.data[0][0]);
+                xMax = Math.max(xMax, s.data[s.data.length - 1][0]);
+            }
+        });
+        if (xMin === Infinity) { xMin = Date.now() - 60000; xMax = Date.now(); }
+        if (xMax === xMin) { xMin -= 1000; }
+
+        ctx.fillStyle = '#333';
+        ctx.textAlign = 'center';
+        ctx.fillText(this.title, width / 2, 14);
+
+        ctx.strokeStyle = '#ccc';
+        ctx.strokeRect(PAD_LEFT, PAD_TOP, plotW, plotH);
+
+        var ranges = this.axes.map(function (a, i) { return this.range(i); }, this);
+
+        // Axis labels: min/mid/max per axis, start/end time
+        ranges.forEach(function (r, i) {
+            ctx.fillStyle = '#666';
+            ctx.textAlign = i === 0 ? 'right' : 'left';
+            var x = i === 0 ? PAD_LEFT - 4 : PAD_LEFT + plotW + 4;
+            for (var k = 0; k <= 2; k++) {
+                var v = r[0] + (r[1] - r[0]) * k / 2;
+                ctx.fillText(v.toFixed(1), x, PAD_TOP + plotH - plotH * k / 2 + 4);
+            }
+            if (this.axes[i].title) {
+                ctx.fillText(this.axes[i].title, x, PAD_TOP - 6);
+            }
+        }, this);
+        ctx.textAlign = 'left';
+        ctx.fillText(new Date(xMin).toLocaleString(), PAD_LEFT, height - 6);
+        ctx.textAlign = 'right';
+        ctx.fillText(new Date(xMax).toLocaleTimeString(), PAD_LEFT + plotW, height - 6);
+
+        this.series.forEach(function (s, n) {
+            var r = ranges[s.axis];
+            ctx.strokeStyle = s.color;
+            ctx.lineWidth = 1.5;
+            ctx.beginPath();
+            var drawing = false;
+            s.data.forEach(function (p) {
+                if (p[1] === null) {
+                    drawing = false;
+                    return;
+                }
+                var x = PAD_LEFT + (p[0] - xMin) / (xMax - xMin) * plotW;
+                var y = PAD_TOP + plotH - (p[1] - r[0]) / (r[1] - r[0]) * plotH;
+                if (drawing) {
+                    ctx.lineTo(x, y);
+                } else {
+                    ctx.moveTo(x, y);
+                    drawing = true;
+                }
+            });
+            ctx.stroke();
+
+            // Legend
+            ctx.fillStyle = s.color;
+            ctx.fillRect(PAD_LEFT + 8 + n * 90, PAD_TOP + 6, 10, 10);
+            ctx.fillStyle = '#333';
+            ctx.textAlign = 'left';
+            ctx.fillText(s.name, PAD_LEFT + 22 + n * 90, PAD_TOP + 15);
+        });
+    };
+
+    global.LineChart = LineChart;
+})(window);
@@ -0,0 +1,81 @@
+/**
+ * @file cmd_queue.h
+ * @brief Lock-free latest-command slot between the serial loop and a worker
+ * @author Yahya
+ *
+ * Only the most recent target of an axis matters, so instead of a queue
+ * that could fill up and lose the newest command, each axis has a single
+ * slot. The serial reader thread is the only producer and overwrites the
+ * slot under a sequence counter (odd while writing); the worker is the
+ * only consumer and copies the slot out, retrying if it raced a write.
+ * The counter also tells the worker how many commands were posted since
+ * its last take, so superseded commands can still be counted. Posting
+ * never fails and never blocks.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <time.h>
+
+/**
+ * @brief Motion command for one axis
+ */
+typedef struct {
+    int value;                  // Azimuth: 1 = clockwise, 0 = counter-clockwise; elevation: angle
+    struct timespec received;   // CLOCK_MONOTONIC time the serial frame was parsed
+} motion_cmd_t;
+
+typedef struct {
+    _Alignas(64) atomic_uint seq;   // Twice the commands posted, +1 while writing (producer)
+    motion_cmd_t cmd;               // Newest command
+    _Alignas(64) unsigned taken;    // Commands posted as of the last take (consumer only)
+} cmd_queue_t;
+
+/**
+ * @brief Reset slot to empty
+ * @param q Slot to initialize
+ */
+static inline void cmd_queue_init(cmd_queue_t *q) {
+    atomic_init(&q->seq, 0);
+    q->taken = 0;
+}
+
+/**
+ * @brief Post a command, replacing any the consumer has not taken (producer side)
+ * @param q Slot
+ * @param cmd Command to copy in
+ */
+static inline void cmd_queue_push(cmd_queue_t *q, const motion_cmd_t *cmd) {
+    unsigned s = atomic_load_explicit(&q->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&q->seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    q->cmd = *cmd;
+    atomic_store_explicit(&q->seq, s + 2, memory_order_release);
+}
+
+/**
+ * @brief Take the newest command (consumer side)
+ * @param q Slot
+ * @param cmd Receives the newest command
+ * @return Commands posted since the last take; all but the newest were superseded
+ */
+static inline size_t cmd_queue_pop_latest(cmd_queue_t *q, motion_cmd_t *cmd) {
+    unsigned before, after;
+
+    do {
+        before = atomic_load_explicit(&q->seq, memory_order_acquire);
+        if (before / 2 == q->taken && !(before & 1)) {
+            return 0;
+        }
+        *cmd = q->cmd;
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&q->seq, memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    size_t posted = before / 2 - q->taken;
+    q->taken = before / 2;
+    return posted;
+}
@@ -0,0 +1,173 @@
+/**
+ * @file histogram.h
+ * @brief Lock-free log-linear latency histogram
+ * @author Yahya
+ *
+ * Values are bucketed HDR-style: exact below 16, above that every power
+ * of two is split into 16 linear sub-buckets, so any recorded value is
+ * reported within 6.25%. Recording is a handful of relaxed atomic adds
+ * and is safe from any number of threads.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define HIST_SUB_BITS 4
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)
+#define HIST_MAX_MSB 40                     // Largest tracked value ~2^41 (ns: ~36 min)
+#define HIST_BUCKETS ((HIST_MAX_MSB - HIST_SUB_BITS + 2) * HIST_SUB_COUNT)
+
+typedef struct {
+    atomic_uint_fast64_t counts[HIST_BUCKETS];
+    atomic_uint_fast64_t total;
+    atomic_uint_fast64_t sum;
+    atomic_uint_fast64_t min;
+    atomic_uint_fast64_t max;
+} histogram_t;
+
+/**
+ * @brief Reset histogram to empty
+ * @param h Histogram
+ */
+static inline void hist_init(histogram_t *h) {
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        atomic_init(&h->counts[i], 0);
+    }
+    atomic_init(&h->total, 0);
+    atomic_init(&h->sum, 0);
+    atomic_init(&h->min, UINT64_MAX);
+    atomic_init(&h->max, 0);
+}
+
+/**
+ * @brief Map a value to its bucket index
+ * @param v Value
+ * @return Bucket index
+ */
+static inline int hist_index(uint64_t v) {
+    if (v < HIST_SUB_COUNT) {
+        return (int)v;
+    }
+
+    int msb = 63 - __builtin_clzll(v);
+    if (msb > HIST_MAX_MSB) {
+        return HIST_BUCKETS - 1;
+    }
+
+    int shift = msb - HIST_SUB_BITS;
+    return (shift + 1) * HIST_SUB_COUNT + (int)((v >> shift) - HIST_SUB_COUNT);
+}
+
+/**
+ * @brief Highest value that maps to a bucket
+ * @param idx Bucket index
+ * @return Inclusive upper bound of the bucket
+ */
+static inline uint64_t hist_bucket_upper(int idx) {
+    if (idx < HIST_SUB_COUNT) {
+        return (uint64_t)idx;
+    }
+
+    int group = idx / HIST_SUB_COUNT;
+    uint64_t lower = (uint64_t)(HIST_SUB_COUNT + idx % HIST_SUB_COUNT) << (group - 1);
+    return lower + (1ULL << (group - 1)) - 1;
+}
+
+/**
+ * @brief Record one value
+ * @param h Histogram
+ * @param v Value
+ */
+static inline void hist_record(histogram_t *h, uint64_t v) {
+    atomic_fetch_add_explicit(&h->counts[hist_index(v)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->total, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum, v, memory_order_relaxed);
+
+    uint64_t cur = atomic_load_explicit(&h->min, memory_order_relaxed);
+    while (v < cur && !atomic_compare_exchange_weak_explicit(
+               &h->min, &cur, v, memory_order_relaxed, memory_order_relaxed)) {
+    }
+
+    cur = atomic_load_explicit(&h->max, memory_order_relaxed);
+    while (v > cur && !atomic_compare_exchange_weak_explicit(
+               &h->max, &cur, v, memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief Estimate a percentile
+ * @param h Histogram
+ * @param pct Percentile (0-100)
+ * @return Upper bound of the bucket holding the percentile, 0 if empty
+ */
+static inline uint64_t hist_percentile(histogram_t *h, double pct) {
+    uint64_t total = atomic_load_explicit(&h->total, memory_order_relaxed);
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t target = (uint64_t)(total * pct / 100.0 + 0.5);
+    if (target == 0) {
+        target = 1;
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += atomic_load_explicit(&h->counts[i], memory_order_relaxed);
+        if (seen >= target) {
+            uint64_t upper = hist_bucket_upper(i);
+            uint64_t max = atomic_load_explicit(&h->max, memory_order_relaxed);
+            return upper < max ? upper : max;
+        }
+    }
+    return atomic_load_explicit(&h->max, memory_order_relaxed);
+}
+
+/**
+ * @brief Print summary and a power-of-two distribution of a nanosecond histogram
+ * @param h Histogram
+ * @param name Label for the report
+ * @param out Output stream
+ */
+static inline void hist_print_us(histogram_t *h, const char *name, FILE *out) {
+    uint64_t total = atomic_load_explicit(&h->total, memory_order_relaxed);
+
+    fprintf(out, "%s: %llu samples\n", name, (unsigned long long)total);
+    if (total == 0) {
+        return;
+    }
+
+    fprintf(out, "  min %.1f us, avg %.1f us, max %.1f us\n",
+            atomic_load_explicit(&h->min, memory_order_relaxed) / 1000.0,
+            (double)atomic_load_explicit(&h->sum, memory_order_relaxed) / total / 1000.0,
+            atomic_load_explicit(&h->max, memory_order_relaxed) / 1000.0);
+    fprintf(out, "  p50 %.1f us, p90 %.1f us, p99 %.1f us, p99.9 %.1f us\n",
+            hist_percentile(h, 50.0) / 1000.0, hist_percentile(h, 90.0) / 1000.0,
+            hist_percentile(h, 99.0) / 1000.0, hist_percentile(h, 99.9) / 1000.0);
+
+    // Collapse sub-buckets into power-of-two microsecond ranges
+    uint64_t rangeCount = 0;
+    uint64_t rangeUpperUs = 1;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        uint64_t upperUs = hist_bucket_upper(i) / 1000;
+
+        if (upperUs >= rangeUpperUs) {
+            if (rangeCount) {
+                fprintf(out, "  < %6llu us: %llu\n",
+                        (unsigned long long)rangeUpperUs, (unsigned long long)rangeCount);
+            }
+            rangeCount = 0;
+            while (rangeUpperUs <= upperUs) {
+                rangeUpperUs <<= 1;
+            }
+        }
+        rangeCount += atomic_load_explicit(&h->counts[i], memory_order_relaxed);
+    }
+    if (rangeCount) {
+        fprintf(out, "  < %6llu us: %llu\n",
+                (unsigned long long)rangeUpperUs, (unsigned long long)rangeCount);
+    }
+}
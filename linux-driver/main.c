@@ -2,27 +2,62 @@
  * @file main.c
  * @brief User-space application for solar tracking motor control
  * @author Yahya
- * 
+ *
  * This application communicates with the ESP32 via UART to receive
  * sun direction commands and controls servo/stepper motors accordingly
  * through the kernel driver interface.
+ *
+ * One process serves any number of trackers listed in a config file. All
+ * serial links are multiplexed on a single epoll loop that only reads and
+ * parses frames. Every axis has a lock-free SPSC command queue drained by
+ * one of a small pool of motion workers, which interleave the step
+ * deadlines of all axes they own, so the serial ports never back up while
+ * a motor is moving and the thread count does not grow with the array.
+ *
+ * With --realtime the workers run under SCHED_FIFO, pinned to dedicated
+ * CPUs, with all memory locked and their stacks pre-faulted, so step
+ * timing does not depend on other load on the Pi.
+ *
+ * The latest frame, axis positions, controller state and counters of every
+ * tracker are published to a seqlock-guarded POSIX shared-memory segment
+ * (see telemetry.h) for local readers such as solar-telemetry.
+ *
+ * Latency histograms and counters are updated with relaxed atomics from the
+ * hot path and served in Prometheus text format over local HTTP by the
+ * same epoll loop (--metrics, default 127.0.0.1:9464/metrics).
  */
 
+#define _GNU_SOURCE     // CPU affinity and pthread_attr_setaffinity_np()
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
+#include <signal.h>
+#include <sched.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <termios.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "cmd_queue.h"
+#include "histogram.h"
+#include "metrics.h"
+#include "telemetry.h"
 
-// Device files for servo and stepper motor control
-#define SERVO_DEV "/dev/plat_drv0"
-#define STEPPER_DEV1 "/dev/plat_drv1"
-#define STEPPER_DEV2 "/dev/plat_drv2"
-#define STEPPER_DEV3 "/dev/plat_drv3"
-#define STEPPER_DEV4 "/dev/plat_drv4"
+// Default motor driver device prefix (servo is <prefix>0, stepper pins <prefix>1-4)
+#define DEVICE_PREFIX "/dev/plat_drv"
 
-// Serial port configuration
+// Serial port configuration, used when no config file is given
 #define SERIAL_PORT "/dev/ttyS0"
 #define BAUD_RATE B115200
 
@@ -32,6 +67,201 @@
 #define STEPPER_STEPS 50
 #define STEP_DELAY_US 2000
 
+// Daemon limits and defaults
+#define MAX_TRACKERS 64
+#define MAX_WORKERS 16
+#define DEFAULT_WORKERS 2
+#define DEFAULT_STATS_INTERVAL 60   // seconds, 0 = only at exit
+#define SERIAL_LINE_MAX 256
+#define MOTOR_RETRY_MAX_S 60        // Longest wait between motor backend reopen attempts
+
+// Metrics endpoint: TCP port on 127.0.0.1, or a unix socket path
+#define METRICS_ADDR "9464"
+#define MAX_METRICS_CLIENTS 4
+#define METRICS_REQUEST_MAX 1024
+
+// Real-time mode defaults (overridable on the command line)
+#define RT_PRIORITY 80              // SCHED_FIFO priority of the motion workers
+#define RT_CPU 3                    // First CPU the motion workers are pinned to
+#define RT_STACK_SIZE (256 * 1024)  // Worker stack size
+#define RT_STACK_PREFAULT (64 * 1024)   // Stack bytes touched before entering the loop
+
+// Actuator axes of one tracker
+typedef enum {
+    AXIS_AZIMUTH = 0,   // Stepper motor, horizontal rotation
+    AXIS_ELEVATION,     // Servo motor, vertical tilt
+    AXIS_COUNT
+} axis_id_t;
+
+// Sun directions, for per-direction command counters
+typedef enum {
+    DIR_LEFT = 0,
+    DIR_RIGHT,
+    DIR_UP,
+    DIR_DOWN,
+    DIR_UNKNOWN,
+    DIR_COUNT
+} direction_id_t;
+
+static const char *const directionNames[DIR_COUNT] = {
+    "left", "right", "up", "down", "unknown"
+};
+
+// What an epoll event refers to
+typedef enum {
+    SOURCE_TIMER,
+    SOURCE_SERIAL,
+    SOURCE_METRICS_LISTEN,
+    SOURCE_METRICS_CLIENT
+} source_kind_t;
+
+typedef struct {
+    source_kind_t kind;
+    void *owner;                // tracker_t or metrics_client_t, NULL otherwise
+} event_source_t;
+
+typedef struct tracker tracker_t;
+typedef struct worker worker_t;
+
+/**
+ * @brief Motor backend operations
+ */
+typedef struct {
+    const char *name;
+    int (*open)(tracker_t *t);
+    int (*servo)(tracker_t *t, int angle);
+    int (*stepper)(tracker_t *t, const int phase[4]);
+    void (*close)(tracker_t *t);
+} motor_backend_t;
+
+/**
+ * @brief Per-axis command queue and motion state
+ */
+typedef struct {
+    axis_id_t id;
+    tracker_t *tracker;
+    worker_t *worker;           // Only this worker takes commands from the slot
+    cmd_queue_t queue;          // Latest command, posted by the serial loop
+
+    // Stepper motion, owned by the worker
+    int stepsLeft;              // Steps still to run, plus one final release tick
+    int stepsDone;
+    int clockwise;
+    struct timespec nextStep;
+
+    // Controller state, owned by the worker
+    int position;               // Azimuth: net steps (clockwise positive); elevation: degrees
+    int target;                 // Azimuth: +1/-1 rotation direction; elevation: degrees
+    unsigned long moves;        // Commands executed
+
+    atomic_ulong coalesced;     // Commands superseded before they ran
+    atomic_int reported;        // Last published position, reported back to the ESP32
+} axis_t;
+
+/**
+ * @brief One tracker: serial link, motor backend and controller state
+ */
+struct tracker {
+    char name[32];
+    char serialPort[64];
+    speed_t baud;
+    const motor_backend_t *backend;
+    char devicePrefix[64];
+
+    event_source_t source;
+    int serialFd;
+    int servoFd;
+    int stepperFd[4];
+    int motorsUp;                   // Backend open; the serial port is only opened while up
+    int motorRetryS;                // Current reopen backoff, doubles up to MOTOR_RETRY_MAX_S
+    int motorRetryIn;               // Seconds until the next reopen attempt
+
+    char line[SERIAL_LINE_MAX];     // Partial frame from the serial port
+    size_t lineLen;
+    char report[32];                // AXIS line being sent back
+    size_t reportLen;               // Its length, 0 when none is pending
+    size_t reportSent;              // Bytes of it already written
+
+    axis_t axes[AXIS_COUNT];
+
+    atomic_ulong frames;        // SUN_DIR frames received
+    atomic_ulong parseErrors;   // Lines that were not valid frames
+    atomic_ulong steps;         // Stepper steps executed
+    atomic_ulong servoMoves;    // Servo moves executed
+    atomic_ulong preempted;     // Rotations cut short by a newer command
+};
+
+/**
+ * @brief Motion worker thread serving a fixed set of axes
+ */
+struct worker {
+    int index;
+    pthread_t thread;
+    sem_t wakeup;               // Posted once per pushed command, drained each pass
+    axis_t **axes;
+    int axisCount;
+};
+
+/**
+ * @brief One HTTP connection to the metrics endpoint
+ */
+typedef struct {
+    event_source_t source;
+    int fd;                     // -1 when the slot is free
+    char request[METRICS_REQUEST_MAX];
+    size_t requestLen;
+    char *response;             // Rendered once the request is complete
+    size_t responseLen;
+    size_t responseSent;
+} metrics_client_t;
+
+/**
+ * @brief Real-time scheduling options
+ */
+typedef struct {
+    int enabled;
+    int priority;
+    int cpu;
+} rt_config_t;
+
+static tracker_t trackers[MAX_TRACKERS];
+static int trackerCount;
+
+static worker_t workers[MAX_WORKERS];
+static int workerCount = DEFAULT_WORKERS;
+
+static const char *configPath;
+static const char *telemetryName = TELEMETRY_SHM_NAME;
+static telemetry_shm_t *telemetry;     // NULL when publishing is disabled
+static int statsInterval = DEFAULT_STATS_INTERVAL;
+static const char *metricsAddr = METRICS_ADDR;
+static int metricsFd = -1;
+static metrics_client_t metricsClients[MAX_METRICS_CLIENTS];
+static struct timespec started;
+
+static volatile sig_atomic_t running = 1;
+
+static rt_config_t rtConfig = {
+    .enabled = 0,
+    .priority = RT_PRIORITY,
+    .cpu = RT_CPU,
+};
+
+// Lateness of each step wakeup relative to its deadline (ns)
+static histogram_t wakeupLatency;
+
+// Serial frame read to first motor output (ns)
+static histogram_t motionLatency;
+
+// Time to execute one stepper tick, and the part spent in driver writes (ns)
+static histogram_t stepDuration;
+static histogram_t stepSyscall;
+
+// Time to parse a frame and dispatch its command (ns)
+static histogram_t controllerCompute;
+
+static atomic_ulong commandsByDirection[DIR_COUNT];
+
 // Stepper motor 4-phase sequence
 const int stepSequence[4][4] = {
     {1, 0, 0, 1},
@@ -40,99 +270,348 @@ const int stepSequence[4][4] = {
     {0, 0, 1, 1}
 };
 
+static const int stepperRelease[4] = {0, 0, 0, 0};
+
 /**
- * @brief Move servo motor to specified angle
- * @param angle Target angle (0-180 degrees)
+ * @brief Nanoseconds from a to b
+ */
+static inline int64_t timespecDiffNs(const struct timespec *a, const struct timespec *b) {
+    return (int64_t)(b->tv_sec - a->tv_sec) * 1000000000LL + (b->tv_nsec - a->tv_nsec);
+}
+
+/**
+ * @brief Advance a timespec by a number of microseconds
+ */
+static inline void timespecAddUs(struct timespec *ts, long us) {
+    ts->tv_nsec += us * 1000L;
+    while (ts->tv_nsec >= 1000000000L) {
+        ts->tv_nsec -= 1000000000L;
+        ts->tv_sec++;
+    }
+}
+
+/**
+ * @brief Write a decimal value to an open driver device
+ * @param fd Device file descriptor
+ * @param value Value to write
  * @return 0 on success, -1 on error
  */
-int moveServo(int angle) {
-    int fd;
+int writeDevice(int fd, int value) {
     char buffer[16];
+    int len = snprintf(buffer, sizeof(buffer), "%d", value);
 
-    if (angle < 0 || angle > 180) {
-        fprintf(stderr, "Error: Servo angle out of range (0-180)\n");
+    if (write(fd, buffer, len) < 0) {
         return -1;
     }
+    return 0;
+}
 
-    fd = open(SERVO_DEV, O_WRONLY);
-    if (fd < 0) {
-        perror("Error opening servo device");
+/**
+ * @brief Open the servo and stepper devices of the kernel driver
+ *
+ * The files stay open for the lifetime of the tracker, so a step costs
+ * four writes instead of four open/write/close round trips.
+ *
+ * @param t Tracker
+ * @return 0 on success, -1 on error
+ */
+int platDrvOpen(tracker_t *t) {
+    char path[80];
+    int i;
+
+    snprintf(path, sizeof(path), "%s0", t->devicePrefix);
+    t->servoFd = open(path, O_WRONLY);
+    if (t->servoFd < 0) {
+        fprintf(stderr, "[%s] Error opening servo device %s: %s\n",
+                t->name, path, strerror(errno));
         return -1;
     }
 
-    snprintf(buffer, sizeof(buffer), "%d", angle);
-    if (write(fd, buffer, strlen(buffer)) < 0) {
+    for (i = 0; i < 4; i++) {
+        snprintf(path, sizeof(path), "%s%d", t->devicePrefix, i + 1);
+        t->stepperFd[i] = open(path, O_WRONLY);
+        if (t->stepperFd[i] < 0) {
+            fprintf(stderr, "[%s] Error opening stepper device %s: %s\n",
+                    t->name, path, strerror(errno));
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Move servo through the kernel driver
+ */
+int platDrvServo(tracker_t *t, int angle) {
+    if (writeDevice(t->servoFd, angle) < 0) {
         perror("Error writing to servo device");
-        close(fd);
         return -1;
     }
+    return 0;
+}
 
-    close(fd);
-    printf("Servo moved to %d degrees\n", angle);
+/**
+ * @brief Drive the four stepper phases through the kernel driver
+ */
+int platDrvStepper(tracker_t *t, const int phase[4]) {
+    for (int i = 0; i < 4; i++) {
+        if (writeDevice(t->stepperFd[i], phase[i]) < 0) {
+            perror("Error writing to stepper device");
+            return -1;
+        }
+    }
     return 0;
 }
 
 /**
- * @brief Write value to specific stepper motor pin
- * @param device Device file path
- * @param value Pin value (0 or 1)
- * @return 0 on success, -1 on error
+ * @brief Close the kernel driver devices
+ */
+void platDrvClose(tracker_t *t) {
+    if (t->servoFd >= 0) {
+        close(t->servoFd);
+        t->servoFd = -1;
+    }
+    for (int i = 0; i < 4; i++) {
+        if (t->stepperFd[i] >= 0) {
+            close(t->stepperFd[i]);
+            t->stepperFd[i] = -1;
+        }
+    }
+}
+
+/**
+ * @brief Simulated motors, for bench testing without hardware
  */
-int writeStepperPin(const char *device, int value) {
-    int fd;
-    char buffer[2];
+int simOpen(tracker_t *t) { (void)t; return 0; }
+int simServo(tracker_t *t, int angle) { (void)t; (void)angle; return 0; }
+int simStepper(tracker_t *t, const int phase[4]) { (void)t; (void)phase; return 0; }
+void simClose(tracker_t *t) { (void)t; }
+
+static const motor_backend_t backends[] = {
+    { "plat_drv", platDrvOpen, platDrvServo, platDrvStepper, platDrvClose },
+    { "sim",      simOpen,     simServo,     simStepper,     simClose },
+};
+
+/**
+ * @brief Look up a motor backend by name
+ * @param name Backend name
+ * @return Backend, or NULL if unknown
+ */
+const motor_backend_t *findBackend(const char *name) {
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+        if (strcmp(backends[i].name, name) == 0) {
+            return &backends[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Wall-clock time for telemetry timestamps
+ * @return CLOCK_REALTIME in nanoseconds
+ */
+uint64_t realtimeNs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief Create and map the shared-memory telemetry segment
+ * @return 0 on success, -1 on error (the daemon runs without telemetry)
+ */
+int telemetryOpen(void) {
+    size_t size = telemetry_size(trackerCount);
+    int fd = shm_open(telemetryName, O_CREAT | O_RDWR, 0644);
 
-    fd = open(device, O_WRONLY);
     if (fd < 0) {
-        perror("Error opening stepper device");
+        fprintf(stderr, "Warning: Cannot create telemetry segment %s: %s\n",
+                telemetryName, strerror(errno));
         return -1;
     }
 
-    snprintf(buffer, sizeof(buffer), "%d", value);
-    if (write(fd, buffer, strlen(buffer)) < 0) {
-        perror("Error writing to stepper device");
+    if (ftruncate(fd, size) < 0) {
+        fprintf(stderr, "Warning: Cannot size telemetry segment: %s\n", strerror(errno));
         close(fd);
         return -1;
     }
 
+    telemetry = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
     close(fd);
+    if (telemetry == MAP_FAILED) {
+        telemetry = NULL;
+        fprintf(stderr, "Warning: Cannot map telemetry segment: %s\n", strerror(errno));
+        return -1;
+    }
+
+    memset(telemetry, 0, size);
+    for (int i = 0; i < trackerCount; i++) {
+        memcpy(telemetry->trackers[i].name, trackers[i].name, sizeof(trackers[i].name));
+    }
+    telemetry->trackerCount = trackerCount;
+    telemetry->pid = getpid();
+    telemetry->startedNs = realtimeNs();
+    atomic_store(&telemetry->heartbeatNs, telemetry->startedNs);
+    telemetry->version = TELEMETRY_VERSION;
+
+    // Readers check the magic last, so they never see a half-built header
+    atomic_thread_fence(memory_order_release);
+    telemetry->magic = TELEMETRY_MAGIC;
+
+    printf("Publishing telemetry to shared memory %s\n", telemetryName);
     return 0;
 }
 
 /**
- * @brief Reset all stepper motor pins to low
+ * @brief Unmap and remove the telemetry segment
  */
-void resetStepper(void) {
-    writeStepperPin(STEPPER_DEV1, 0);
-    writeStepperPin(STEPPER_DEV2, 0);
-    writeStepperPin(STEPPER_DEV3, 0);
-    writeStepperPin(STEPPER_DEV4, 0);
+void telemetryClose(void) {
+    if (!telemetry) {
+        return;
+    }
+    munmap(telemetry, telemetry_size(trackerCount));
+    shm_unlink(telemetryName);
+    telemetry = NULL;
 }
 
 /**
- * @brief Rotate stepper motor
- * @param steps Number of steps to rotate
- * @param clockwise Direction (1 = clockwise, 0 = counter-clockwise)
- * @return 0 on success, -1 on error
+ * @brief Publish link state and, if given, the latest frame (serial loop only)
+ * @param t Tracker
+ * @param line Frame as received, or NULL to keep the previous one
+ * @param direction Parsed direction, or NULL to keep the previous one
+ */
+void publishLink(tracker_t *t, const char *line, const char *direction) {
+    if (!telemetry) {
+        return;
+    }
+
+    telemetry_link_t *link = &telemetry->trackers[t - trackers].link;
+
+    seqlock_write_begin(&link->seq);
+    link->linkUp = t->serialFd >= 0;
+    if (line) {
+        link->frameTimeNs = realtimeNs();
+        snprintf(link->line, sizeof(link->line), "%s", line);
+        snprintf(link->direction, sizeof(link->direction), "%s", direction);
+    }
+    link->frames = atomic_load_explicit(&t->frames, memory_order_relaxed);
+    link->parseErrors = atomic_load_explicit(&t->parseErrors, memory_order_relaxed);
+    seqlock_write_end(&link->seq);
+}
+
+/**
+ * @brief Publish position and controller state of an axis (owning worker only)
+ * @param axis Axis
  */
-int rotateStepper(int steps, int clockwise) {
-    for (int i = 0; i < steps; i++) {
-        int stepIndex = clockwise ? (i % 4) : (3 - (i % 4));
+void publishAxis(axis_t *axis) {
+    atomic_store_explicit(&axis->reported, axis->position, memory_order_relaxed);
+    if (!telemetry) {
+        return;
+    }
+
+    tracker_t *t = axis->tracker;
+    telemetry_axis_t *out = &telemetry->trackers[t - trackers].axes[axis->id];
+
+    seqlock_write_begin(&out->seq);
+    out->position = axis->position;
+    out->target = axis->target;
+    out->stepsLeft = axis->stepsLeft;
+    out->moving = axis->stepsLeft > 0;
+    out->updatedNs = realtimeNs();
+    out->moves = axis->moves;
+    out->steps = axis->id == AXIS_AZIMUTH
+               ? atomic_load_explicit(&t->steps, memory_order_relaxed) : 0;
+    out->coalesced = atomic_load_explicit(&axis->coalesced, memory_order_relaxed);
+    seqlock_write_end(&out->seq);
+}
 
-        writeStepperPin(STEPPER_DEV1, stepSequence[stepIndex][0]);
-        writeStepperPin(STEPPER_DEV2, stepSequence[stepIndex][1]);
-        writeStepperPin(STEPPER_DEV3, stepSequence[stepIndex][2]);
-        writeStepperPin(STEPPER_DEV4, stepSequence[stepIndex][3]);
+/**
+ * @brief Move servo motor to specified angle
+ * @param t Tracker
+ * @param angle Target angle (0-180 degrees)
+ * @return 0 on success, -1 on error
+ */
+int moveServo(tracker_t *t, int angle) {
+    if (angle < 0 || angle > 180) {
+        fprintf(stderr, "Error: Servo angle out of range (0-180)\n");
+        return -1;
+    }
 
-        usleep(STEP_DELAY_US);
+    if (t->backend->servo(t, angle) < 0) {
+        return -1;
     }
 
-    resetStepper();
-    printf("Stepper rotated %d steps %s\n", steps, 
-           clockwise ? "clockwise" : "counter-clockwise");
+    atomic_fetch_add_explicit(&t->servoMoves, 1, memory_order_relaxed);
+    if (!rtConfig.enabled) {
+        printf("[%s] Servo moved to %d degrees\n", t->name, angle);
+    }
     return 0;
 }
 
+/**
+ * @brief Start (or restart) a stepper rotation
+ * @param axis Azimuth axis
+ * @param clockwise Direction (1 = clockwise, 0 = counter-clockwise)
+ * @param now Current time; the first step is due immediately
+ */
+void startRotation(axis_t *axis, int clockwise, const struct timespec *now) {
+    if (axis->stepsLeft > 0) {
+        atomic_fetch_add_explicit(&axis->tracker->preempted, 1, memory_order_relaxed);
+        if (!rtConfig.enabled) {
+            printf("[%s] Stepper preempted after %d steps\n",
+                   axis->tracker->name, axis->stepsDone);
+        }
+    }
+
+    axis->clockwise = clockwise;
+    axis->stepsLeft = STEPPER_STEPS + 1;
+    axis->stepsDone = 0;
+    axis->nextStep = *now;
+}
+
+/**
+ * @brief Run one due stepper tick and schedule the next one
+ *
+ * Deadlines are absolute, so time spent writing pins does not add up.
+ * The tick after the last step releases the coils.
+ *
+ * @param axis Azimuth axis with a rotation in progress
+ */
+void stepAxis(axis_t *axis) {
+    tracker_t *t = axis->tracker;
+    struct timespec before, after;
+
+    if (axis->stepsLeft == 1) {
+        clock_gettime(CLOCK_MONOTONIC, &before);
+        t->backend->stepper(t, stepperRelease);
+        clock_gettime(CLOCK_MONOTONIC, &after);
+        hist_record(&stepSyscall, (uint64_t)timespecDiffNs(&before, &after));
+
+        axis->stepsLeft = 0;
+        if (!rtConfig.enabled) {
+            printf("[%s] Stepper rotated %d steps %s\n", t->name, axis->stepsDone,
+                   axis->clockwise ? "clockwise" : "counter-clockwise");
+        }
+        return;
+    }
+
+    int i = axis->stepsDone;
+    int stepIndex = axis->clockwise ? (i % 4) : (3 - (i % 4));
+
+    clock_gettime(CLOCK_MONOTONIC, &before);
+    t->backend->stepper(t, stepSequence[stepIndex]);
+    clock_gettime(CLOCK_MONOTONIC, &after);
+    hist_record(&stepSyscall, (uint64_t)timespecDiffNs(&before, &after));
+
+    atomic_fetch_add_explicit(&t->steps, 1, memory_order_relaxed);
+
+    axis->position += axis->clockwise ? 1 : -1;
+    axis->stepsDone++;
+    axis->stepsLeft--;
+    timespecAddUs(&axis->nextStep, STEP_DELAY_US);
+}
+
 /**
  * @brief Parse sun direction command from ESP32
  * @param line Command line from serial input
@@ -140,73 +619,1153 @@ int rotateStepper(int steps, int clockwise) {
  */
 const char* parseSunDirection(const char *line) {
     static char direction[32];
-    
+
     if (sscanf(line, "SUN_DIR:%31s", direction) == 1) {
         return direction;
     }
-    
+
     return NULL;
 }
 
+/**
+ * @brief Touch the top of the current thread's stack
+ *
+ * Runs before the real-time loop so the first deep call chain does not
+ * take page faults in the middle of a step.
+ */
+void prefaultStack(void) {
+    volatile unsigned char buffer[RT_STACK_PREFAULT];
+
+    for (size_t i = 0; i < sizeof(buffer); i += 4096) {
+        buffer[i] = 0;
+    }
+}
+
+/**
+ * @brief Lock memory and raise the calling (serial loop) thread
+ * @return 0 on success, -1 on error
+ */
+int setupRealtime(void) {
+    struct sched_param param = { .sched_priority = rtConfig.priority - 1 };
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0) {
+        perror("Error locking memory");
+        return -1;
+    }
+
+    // The serial loop stays just below the workers so it never delays a step
+    if (sched_setscheduler(0, SCHED_FIFO, &param) < 0) {
+        perror("Error setting SCHED_FIFO");
+        return -1;
+    }
+
+    prefaultStack();
+    printf("Real-time mode: SCHED_FIFO priority %d, workers from CPU %d\n",
+           rtConfig.priority, rtConfig.cpu);
+    return 0;
+}
+
+/**
+ * @brief Build thread attributes for a motion worker
+ * @param attr Attributes to initialize
+ * @param index Worker index; workers are spread over consecutive CPUs
+ * @return 0 on success, -1 on error
+ */
+int initWorkerAttr(pthread_attr_t *attr, int index) {
+    struct sched_param param = { .sched_priority = rtConfig.priority };
+    long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+    cpu_set_t cpus;
+
+    pthread_attr_init(attr);
+    if (!rtConfig.enabled) {
+        return 0;
+    }
+
+    CPU_ZERO(&cpus);
+    CPU_SET((rtConfig.cpu + index) % (cpuCount > 0 ? cpuCount : 1), &cpus);
+
+    if (pthread_attr_setstacksize(attr, RT_STACK_SIZE) != 0 ||
+        pthread_attr_setinheritsched(attr, PTHREAD_EXPLICIT_SCHED) != 0 ||
+        pthread_attr_setschedpolicy(attr, SCHED_FIFO) != 0 ||
+        pthread_attr_setschedparam(attr, &param) != 0 ||
+        pthread_attr_setaffinity_np(attr, sizeof(cpus), &cpus) != 0) {
+        fprintf(stderr, "Error: Cannot configure real-time worker attributes\n");
+        pthread_attr_destroy(attr);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Start the newest queued command of an axis, if any
+ * @param axis Axis owned by the calling worker
+ * @param now Current time
+ */
+void pollAxisQueue(axis_t *axis, const struct timespec *now) {
+    motion_cmd_t cmd;
+
+    // Only the most recent target matters
+    size_t drained = cmd_queue_pop_latest(&axis->queue, &cmd);
+    if (drained == 0) {
+        return;
+    }
+    atomic_fetch_add_explicit(&axis->coalesced, drained - 1, memory_order_relaxed);
+
+    if (axis->id == AXIS_AZIMUTH) {
+        startRotation(axis, cmd.value, now);
+        axis->target = cmd.value ? 1 : -1;
+    } else {
+        axis->target = cmd.value;
+        if (moveServo(axis->tracker, cmd.value) == 0) {
+            axis->position = cmd.value;
+        }
+    }
+    hist_record(&motionLatency, (uint64_t)timespecDiffNs(&cmd.received, now));
+
+    axis->moves++;
+    publishAxis(axis);
+}
+
+/**
+ * @brief Motion worker thread
+ *
+ * Picks up new commands, runs every stepper tick that is due, then sleeps
+ * until the earliest pending deadline, or until a command arrives when
+ * no axis is moving.
+ *
+ * @param arg Worker
+ * @return NULL
+ */
+void *motionWorker(void *arg) {
+    worker_t *w = arg;
+    struct timespec now, next;
+
+    if (rtConfig.enabled) {
+        prefaultStack();
+    }
+
+    while (running) {
+        int moving = 0;
+
+        // Posts that piled up while stepping are covered by the poll below;
+        // one that lands after this still wakes the sem_wait
+        while (sem_trywait(&w->wakeup) == 0) {
+        }
+        if (!running) {
+            break;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        for (int i = 0; i < w->axisCount; i++) {
+            pollAxisQueue(w->axes[i], &now);
+        }
+
+        for (int i = 0; i < w->axisCount; i++) {
+            axis_t *axis = w->axes[i];
+
+            if (axis->stepsLeft == 0) {
+                continue;
+            }
+
+            // Read the clock per axis: an earlier axis's step delays this one
+            clock_gettime(CLOCK_MONOTONIC, &now);
+
+            int64_t late = timespecDiffNs(&axis->nextStep, &now);
+            if (late >= 0) {
+                struct timespec done;
+
+                hist_record(&wakeupLatency, (uint64_t)late);
+                stepAxis(axis);
+                publishAxis(axis);
+
+                clock_gettime(CLOCK_MONOTONIC, &done);
+                hist_record(&stepDuration, (uint64_t)timespecDiffNs(&now, &done));
+            }
+
+            if (axis->stepsLeft > 0 &&
+                (!moving || timespecDiffNs(&axis->nextStep, &next) > 0)) {
+                next = axis->nextStep;
+                moving = 1;
+            }
+        }
+
+        if (!moving) {
+            sem_wait(&w->wakeup);
+            continue;
+        }
+
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR) {
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Hand a command to an axis worker without blocking
+ * @param axis Target axis
+ * @param value Command value (see motion_cmd_t)
+ * @param received Time the serial frame was read
+ */
+void submitCommand(axis_t *axis, int value, const struct timespec *received) {
+    motion_cmd_t cmd = { .value = value, .received = *received };
+
+    // Replaces a command the worker has not started yet: the newest target wins
+    cmd_queue_push(&axis->queue, &cmd);
+    sem_post(&axis->worker->wakeup);
+}
+
+/**
+ * @brief Handle one complete line from a tracker's serial port
+ * @param t Tracker
+ * @param line NUL-terminated line without newline
+ * @param received Time the line was read
+ */
+void handleLine(tracker_t *t, const char *line, const struct timespec *received) {
+    struct timespec start, done;
+    direction_id_t dir;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    const char *direction = parseSunDirection(line);
+    if (!direction) {
+        if (line[0] != '\0') {
+            atomic_fetch_add_explicit(&t->parseErrors, 1, memory_order_relaxed);
+            publishLink(t, NULL, NULL);
+        }
+        return;  // Invalid command, skip
+    }
+    atomic_fetch_add_explicit(&t->frames, 1, memory_order_relaxed);
+
+    printf("\n[%s] Received direction: %s\n", t->name, direction);
+
+    // Hand the command to the matching axis worker
+    if (strcmp(direction, "Venstre") == 0) {
+        printf("[%s] Action: Rotate LEFT\n", t->name);
+        submitCommand(&t->axes[AXIS_AZIMUTH], 0, received);
+        dir = DIR_LEFT;
+
+    } else if (strcmp(direction, "Højre") == 0 ||
+              strcmp(direction, "Hojre") == 0) {
+        printf("[%s] Action: Rotate RIGHT\n", t->name);
+        submitCommand(&t->axes[AXIS_AZIMUTH], 1, received);
+        dir = DIR_RIGHT;
+
+    } else if (strcmp(direction, "Op") == 0) {
+        printf("[%s] Action: Tilt UP\n", t->name);
+        submitCommand(&t->axes[AXIS_ELEVATION], SERVO_UP_ANGLE, received);
+        dir = DIR_UP;
+
+    } else if (strcmp(direction, "Ned") == 0) {
+        printf("[%s] Action: Tilt DOWN\n", t->name);
+        submitCommand(&t->axes[AXIS_ELEVATION], SERVO_DOWN_ANGLE, received);
+        dir = DIR_DOWN;
+
+    } else {
+        printf("[%s] Action: Unknown direction, no movement\n", t->name);
+        dir = DIR_UNKNOWN;
+    }
+    atomic_fetch_add_explicit(&commandsByDirection[dir], 1, memory_order_relaxed);
+
+    publishLink(t, line, direction);
+
+    clock_gettime(CLOCK_MONOTONIC, &done);
+    hist_record(&controllerCompute, (uint64_t)timespecDiffNs(&start, &done));
+}
+
+/**
+ * @brief Report the axis positions back to the ESP32 (serial loop only)
+ *
+ * Sends one "AXIS:<azimuth>,<elevation>" line. The port is non-blocking;
+ * if only part of a line fits, the rest is sent first on the next tick and
+ * that tick's report is skipped, so the ESP32 never sees a truncated line.
+ * @param t Tracker with an open serial port
+ */
+void reportAxes(tracker_t *t) {
+    if (t->reportLen == 0) {
+        t->reportLen = snprintf(t->report, sizeof(t->report), "AXIS:%d,%d\n",
+                                atomic_load_explicit(&t->axes[AXIS_AZIMUTH].reported, memory_order_relaxed),
+                                atomic_load_explicit(&t->axes[AXIS_ELEVATION].reported, memory_order_relaxed));
+        t->reportSent = 0;
+    }
+
+    ssize_t n = write(t->serialFd, t->report + t->reportSent, t->reportLen - t->reportSent);
+    if (n < 0) {
+        if (errno != EAGAIN) {
+            fprintf(stderr, "[%s] Warning: cannot report axes: %s\n", t->name, strerror(errno));
+        }
+        // Nothing of a fresh line went out, so nothing needs finishing
+        if (t->reportSent == 0) {
+            t->reportLen = 0;
+        }
+        return;
+    }
+    t->reportSent += n;
+    if (t->reportSent == t->reportLen) {
+        t->reportLen = 0;
+    }
+}
+
+/**
+ * @brief Drain a readable serial port and dispatch complete lines
+ * @param t Tracker
+ * @return 0 while the port is usable, -1 if it failed or hung up
+ */
+int readSerial(tracker_t *t) {
+    char buffer[512];
+    struct timespec received;
+
+    for (;;) {
+        ssize_t n = read(t->serialFd, buffer, sizeof(buffer));
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                return 0;
+            }
+            fprintf(stderr, "[%s] Error reading %s: %s\n",
+                    t->name, t->serialPort, strerror(errno));
+            return -1;
+        }
+        if (n == 0) {
+            return 0;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &received);
+
+        for (ssize_t i = 0; i < n; i++) {
+            char c = buffer[i];
+
+            if (c == '\n' || c == '\r') {
+                t->line[t->lineLen] = '\0';
+                handleLine(t, t->line, &received);
+                t->lineLen = 0;
+            } else if (t->lineLen < sizeof(t->line) - 1) {
+                t->line[t->lineLen++] = c;
+            } else {
+                // Overlong line: drop it and resynchronize on the next newline
+                atomic_fetch_add_explicit(&t->parseErrors, 1, memory_order_relaxed);
+                t->lineLen = 0;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Open a tracker's motor backend
+ *
+ * On failure whatever was opened is released and the next attempt is
+ * backed off, so one missing driver only takes its own tracker down.
+ * @param t Tracker
+ * @return 0 on success, -1 on error
+ */
+int openMotors(tracker_t *t) {
+    if (t->backend->open(t) == 0) {
+        t->motorsUp = 1;
+        t->motorRetryS = 0;
+        return 0;
+    }
+
+    t->backend->close(t);
+    t->motorsUp = 0;
+    t->motorRetryS = t->motorRetryS == 0 ? 1 : t->motorRetryS * 2;
+    if (t->motorRetryS > MOTOR_RETRY_MAX_S) {
+        t->motorRetryS = MOTOR_RETRY_MAX_S;
+    }
+    t->motorRetryIn = t->motorRetryS;
+    fprintf(stderr, "[%s] Motors down, retrying in %d s\n", t->name, t->motorRetryS);
+    return -1;
+}
+
+/**
+ * @brief Open a tracker's serial port in raw, non-blocking mode
+ * @param t Tracker
+ * @return 0 on success, -1 on error
+ */
+int openSerial(tracker_t *t) {
+    struct termios tio;
+
+    t->serialFd = open(t->serialPort, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (t->serialFd < 0) {
+        fprintf(stderr, "[%s] Error: Cannot open serial port %s: %s\n",
+                t->name, t->serialPort, strerror(errno));
+        return -1;
+    }
+
+    // Pseudo terminals and plain files (bench setups) may refuse termios
+    if (tcgetattr(t->serialFd, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, t->baud);
+        cfsetospeed(&tio, t->baud);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tcsetattr(t->serialFd, TCSANOW, &tio);
+    }
+
+    t->lineLen = 0;
+    t->reportLen = 0;
+    return 0;
+}
+
+/**
+ * @brief Convert a numeric baud rate to a termios speed
+ * @param baud Baud rate
+ * @return termios speed, or 0 if unsupported
+ */
+speed_t parseBaud(long baud) {
+    switch (baud) {
+    case 9600:   return B9600;
+    case 19200:  return B19200;
+    case 38400:  return B38400;
+    case 57600:  return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default:     return 0;
+    }
+}
+
+/**
+ * @brief Add a tracker to the table
+ * @return Tracker, or NULL if the table is full
+ */
+tracker_t *addTracker(const char *name, const char *port, speed_t baud,
+                      const motor_backend_t *backend, const char *prefix) {
+    if (trackerCount >= MAX_TRACKERS) {
+        fprintf(stderr, "Error: More than %d trackers configured\n", MAX_TRACKERS);
+        return NULL;
+    }
+
+    tracker_t *t = &trackers[trackerCount++];
+    snprintf(t->name, sizeof(t->name), "%s", name);
+    snprintf(t->serialPort, sizeof(t->serialPort), "%s", port);
+    snprintf(t->devicePrefix, sizeof(t->devicePrefix), "%s", prefix);
+    t->baud = baud;
+    t->backend = backend;
+    t->source.kind = SOURCE_SERIAL;
+    t->source.owner = t;
+    t->serialFd = -1;
+    t->servoFd = -1;
+    for (int i = 0; i < 4; i++) {
+        t->stepperFd[i] = -1;
+    }
+    return t;
+}
+
+/**
+ * @brief Load trackers from a config file
+ *
+ * One tracker per line, '#' starts a comment:
+ *   <name> <serial-port> <baud> <backend> [device-prefix]
+ * Backends: plat_drv (kernel driver, default prefix /dev/plat_drv), sim.
+ *
+ * @param path Config file path
+ * @return 0 on success, -1 on error
+ */
+int loadConfig(const char *path) {
+    FILE *f = fopen(path, "r");
+    char line[256];
+    int lineNo = 0;
+
+    if (!f) {
+        fprintf(stderr, "Error: Cannot open config %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), f)) {
+        char name[32], port[64], backendName[16], prefix[64] = DEVICE_PREFIX;
+        long baud;
+
+        lineNo++;
+        line[strcspn(line, "#\r\n")] = 0;
+
+        int fields = sscanf(line, "%31s %63s %ld %15s %63s", name, port, &baud, backendName, prefix);
+        if (fields <= 0) {
+            continue;  // Blank or comment line
+        }
+        if (fields < 4) {
+            fprintf(stderr, "%s:%d: expected <name> <port> <baud> <backend> [prefix]\n",
+                    path, lineNo);
+            fclose(f);
+            return -1;
+        }
+
+        speed_t speed = parseBaud(baud);
+        if (!speed) {
+            fprintf(stderr, "%s:%d: unsupported baud rate %ld\n", path, lineNo, baud);
+            fclose(f);
+            return -1;
+        }
+
+        const motor_backend_t *backend = findBackend(backendName);
+        if (!backend) {
+            fprintf(stderr, "%s:%d: unknown motor backend '%s'\n", path, lineNo, backendName);
+            fclose(f);
+            return -1;
+        }
+
+        if (!addTracker(name, port, speed, backend, prefix)) {
+            fclose(f);
+            return -1;
+        }
+    }
+
+    fclose(f);
+    if (trackerCount == 0) {
+        fprintf(stderr, "Error: No trackers in %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Distribute all axes round-robin over the motion workers
+ *
+ * Axes are numbered tracker by tracker, so with two or more workers the
+ * azimuth and elevation axis of a tracker always move in parallel.
+ *
+ * @return 0 on success, -1 on error
+ */
+int assignAxes(void) {
+    int total = trackerCount * AXIS_COUNT;
+
+    if (workerCount > total) {
+        workerCount = total;
+    }
+
+    for (int w = 0; w < workerCount; w++) {
+        workers[w].index = w;
+        workers[w].axes = calloc((total + workerCount - 1) / workerCount, sizeof(axis_t *));
+        if (!workers[w].axes) {
+            return -1;
+        }
+        sem_init(&workers[w].wakeup, 0, 0);
+    }
+
+    for (int g = 0; g < total; g++) {
+        tracker_t *t = &trackers[g / AXIS_COUNT];
+        axis_t *axis = &t->axes[g % AXIS_COUNT];
+        worker_t *w = &workers[g % workerCount];
+
+        axis->id = g % AXIS_COUNT;
+        axis->tracker = t;
+        axis->worker = w;
+        cmd_queue_init(&axis->queue);
+        w->axes[w->axisCount++] = axis;
+    }
+    return 0;
+}
+
+/**
+ * @brief Render all metrics in Prometheus text format
+ * @param len Receives the length of the text
+ * @return Heap buffer owned by the caller, or NULL on error
+ */
+char *renderMetrics(size_t *len) {
+    char *text = NULL;
+    struct timespec now;
+    FILE *out = open_memstream(&text, len);
+    int i, a;
+
+    if (!out) {
+        return NULL;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    metrics_header(out, "solar_tracker_uptime_seconds", "gauge", "Seconds since the daemon started");
+    fprintf(out, "solar_tracker_uptime_seconds %.3f\n", timespecDiffNs(&started, &now) / 1e9);
+
+    metrics_header(out, "solar_tracker_commands_total", "counter", "Sun direction commands received");
+    for (i = 0; i < DIR_COUNT; i++) {
+        fprintf(out, "solar_tracker_commands_total{direction=\"%s\"} %lu\n", directionNames[i],
+                atomic_load_explicit(&commandsByDirection[i], memory_order_relaxed));
+    }
+
+    // Per-tracker counter families
+    static const struct {
+        const char *name;
+        const char *type;
+        const char *help;
+    } families[] = {
+        { "solar_tracker_link_up", "gauge", "Serial port open" },
+        { "solar_tracker_frames_total", "counter", "SUN_DIR frames received" },
+        { "solar_tracker_parse_errors_total", "counter", "Serial lines that were not valid frames" },
+        { "solar_tracker_steps_total", "counter", "Stepper steps executed" },
+        { "solar_tracker_servo_moves_total", "counter", "Servo moves executed" },
+        { "solar_tracker_preempted_rotations_total", "counter", "Rotations cut short by a newer command" },
+    };
+    for (size_t f = 0; f < sizeof(families) / sizeof(families[0]); f++) {
+        metrics_header(out, families[f].name, families[f].type, families[f].help);
+        for (i = 0; i < trackerCount; i++) {
+            tracker_t *t = &trackers[i];
+            unsigned long value =
+                f == 0 ? (unsigned long)(t->serialFd >= 0) :
+                f == 1 ? atomic_load_explicit(&t->frames, memory_order_relaxed) :
+                f == 2 ? atomic_load_explicit(&t->parseErrors, memory_order_relaxed) :
+                f == 3 ? atomic_load_explicit(&t->steps, memory_order_relaxed) :
+                f == 4 ? atomic_load_explicit(&t->servoMoves, memory_order_relaxed) :
+                         atomic_load_explicit(&t->preempted, memory_order_relaxed);
+
+            fprintf(out, "%s{tracker=\"", families[f].name);
+            metrics_label(out, t->name);
+            fprintf(out, "\"} %lu\n", value);
+        }
+    }
+
+    // Per-axis superseded commands
+    metrics_header(out, "solar_tracker_coalesced_commands_total", "counter",
+                   "Commands superseded by a newer one before they ran");
+    for (i = 0; i < trackerCount; i++) {
+        for (a = 0; a < AXIS_COUNT; a++) {
+            fprintf(out, "solar_tracker_coalesced_commands_total{tracker=\"");
+            metrics_label(out, trackers[i].name);
+            fprintf(out, "\",axis=\"%s\"} %lu\n", a == AXIS_AZIMUTH ? "azimuth" : "elevation",
+                    atomic_load_explicit(&trackers[i].axes[a].coalesced, memory_order_relaxed));
+        }
+    }
+
+    metrics_histogram(out, "solar_tracker_frame_to_motion_seconds",
+                      "Serial frame read to first motor output", &motionLatency);
+    metrics_histogram(out, "solar_tracker_step_duration_seconds",
+                      "Execution time of one stepper tick", &stepDuration);
+    metrics_histogram(out, "solar_tracker_step_syscall_seconds",
+                      "Time per stepper tick spent in driver writes", &stepSyscall);
+    metrics_histogram(out, "solar_tracker_controller_compute_seconds",
+                      "Time to parse a frame and dispatch its command", &controllerCompute);
+    metrics_histogram(out, "solar_tracker_step_wakeup_latency_seconds",
+                      "Lateness of stepper wakeups relative to their deadline", &wakeupLatency);
+
+    if (fclose(out) != 0) {
+        free(text);
+        return NULL;
+    }
+    return text;
+}
+
+/**
+ * @brief Open the metrics listening socket and add it to the epoll set
+ *
+ * A plain number is a TCP port bound to 127.0.0.1; anything starting with
+ * '/' is a unix socket path (curl --unix-socket PATH http://x/metrics).
+ *
+ * @param epollFd Epoll instance
+ * @return 0 on success, -1 on error (the daemon runs without metrics)
+ */
+int metricsListen(int epollFd) {
+    static event_source_t listenSource = { SOURCE_METRICS_LISTEN, NULL };
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &listenSource };
+    int one = 1;
+
+    for (int i = 0; i < MAX_METRICS_CLIENTS; i++) {
+        metricsClients[i].fd = -1;
+        metricsClients[i].source.kind = SOURCE_METRICS_CLIENT;
+        metricsClients[i].source.owner = &metricsClients[i];
+    }
+
+    if (metricsAddr[0] == '/') {
+        struct sockaddr_un addr = { .sun_family = AF_UNIX };
+
+        snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", metricsAddr);
+        unlink(metricsAddr);
+        metricsFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (metricsFd < 0 || bind(metricsFd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+            goto fail;
+        }
+    } else {
+        struct sockaddr_in addr = {
+            .sin_family = AF_INET,
+            .sin_port = htons(atoi(metricsAddr)),
+            .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+        };
+
+        metricsFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (metricsFd < 0) {
+            goto fail;
+        }
+        setsockopt(metricsFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(metricsFd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+            goto fail;
+        }
+    }
+
+    if (listen(metricsFd, MAX_METRICS_CLIENTS) < 0 ||
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, metricsFd, &ev) < 0) {
+        goto fail;
+    }
+
+    printf("Serving metrics on %s%s/metrics\n",
+           metricsAddr[0] == '/' ? "unix:" : "http://127.0.0.1:", metricsAddr);
+    return 0;
+
+fail:
+    fprintf(stderr, "Warning: Cannot serve metrics on %s: %s\n", metricsAddr, strerror(errno));
+    if (metricsFd >= 0) {
+        close(metricsFd);
+        metricsFd = -1;
+    }
+    return -1;
+}
+
+/**
+ * @brief Close a metrics connection and free its slot
+ */
+void metricsClientClose(int epollFd, metrics_client_t *c) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    free(c->response);
+    c->fd = -1;
+    c->response = NULL;
+}
+
+/**
+ * @brief Accept pending metrics connections
+ */
+void metricsAccept(int epollFd) {
+    for (;;) {
+        int fd = accept4(metricsFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+
+        metrics_client_t *c = NULL;
+        for (int i = 0; i < MAX_METRICS_CLIENTS; i++) {
+            if (metricsClients[i].fd < 0) {
+                c = &metricsClients[i];
+                break;
+            }
+        }
+        if (!c) {
+            close(fd);  // Scrapers retry; the serial loop must not queue work
+            continue;
+        }
+
+        c->fd = fd;
+        c->requestLen = 0;
+        c->responseLen = 0;
+        c->responseSent = 0;
+
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &c->source };
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+/**
+ * @brief Advance one metrics connection: read the request, then send the response
+ *
+ * Both directions are non-blocking, so a slow scraper never stalls the
+ * serial loop.
+ */
+void metricsClientEvent(int epollFd, metrics_client_t *c, uint32_t events) {
+    if (events & (EPOLLHUP | EPOLLERR)) {
+        metricsClientClose(epollFd, c);
+        return;
+    }
+
+    if (!c->response) {
+        ssize_t n = read(c->fd, c->request + c->requestLen,
+                         sizeof(c->request) - 1 - c->requestLen);
+        if (n <= 0) {
+            if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+                metricsClientClose(epollFd, c);
+            }
+            return;
+        }
+        c->requestLen += n;
+        c->request[c->requestLen] = '\0';
+
+        if (!strstr(c->request, "\r\n\r\n") && c->requestLen < sizeof(c->request) - 1) {
+            return;  // Headers not complete yet
+        }
+
+        size_t bodyLen = 0;
+        char *body = NULL;
+        int found = strncmp(c->request, "GET /metrics ", 13) == 0 ||
+                    strncmp(c->request, "GET / ", 6) == 0;
+
+        if (found) {
+            body = renderMetrics(&bodyLen);
+        }
+
+        FILE *out = open_memstream(&c->response, &c->responseLen);
+        if (!out) {
+            free(body);
+            metricsClientClose(epollFd, c);
+            return;
+        }
+        if (body) {
+            fprintf(out, "HTTP/1.1 200 OK\r\n"
+                         "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                         "Content-Length: %zu\r\nConnection: close\r\n\r\n", bodyLen);
+            fwrite(body, 1, bodyLen, out);
+        } else {
+            fprintf(out, "HTTP/1.1 %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+                    found ? "500 Internal Server Error" : "404 Not Found");
+        }
+        fclose(out);
+        free(body);
+
+        struct epoll_event ev = { .events = EPOLLOUT, .data.ptr = &c->source };
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, c->fd, &ev);
+        return;
+    }
+
+    ssize_t n = send(c->fd, c->response + c->responseSent,
+                     c->responseLen - c->responseSent, MSG_NOSIGNAL);
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EINTR) {
+            metricsClientClose(epollFd, c);
+        }
+        return;
+    }
+
+    c->responseSent += n;
+    if (c->responseSent == c->responseLen) {
+        metricsClientClose(epollFd, c);
+    }
+}
+
+/**
+ * @brief Print aggregate throughput and latency statistics
+ * @param elapsed Seconds covered by the counters, for rates
+ */
+void printStats(double elapsed) {
+    unsigned long frames = 0, errors = 0, steps = 0, moves = 0, coalesced = 0, preempted = 0;
+
+    printf("\n=== Statistics (%d trackers, %d workers, %.0f s) ===\n",
+           trackerCount, workerCount, elapsed);
+
+    for (int i = 0; i < trackerCount; i++) {
+        tracker_t *t = &trackers[i];
+        unsigned long f = atomic_load(&t->frames);
+        unsigned long e = atomic_load(&t->parseErrors);
+        unsigned long s = atomic_load(&t->steps);
+        unsigned long m = atomic_load(&t->servoMoves);
+        unsigned long p = atomic_load(&t->preempted);
+        unsigned long c = 0;
+
+        for (int a = 0; a < AXIS_COUNT; a++) {
+            c += atomic_load(&t->axes[a].coalesced);
+        }
+
+        printf("%-16s %s frames %lu, errors %lu, steps %lu, servo %lu, coalesced %lu, preempted %lu\n",
+               t->name, t->serialFd >= 0 ? "up  " : "down", f, e, s, m, c, p);
+
+        frames += f; errors += e; steps += s; moves += m; coalesced += c; preempted += p;
+    }
+
+    printf("Total: %lu frames (%.1f/s), %lu steps (%.1f/s), %lu servo moves, "
+           "%lu parse errors, %lu coalesced, %lu preempted\n",
+           frames, elapsed > 0 ? frames / elapsed : 0.0, steps,
+           elapsed > 0 ? steps / elapsed : 0.0, moves, errors, coalesced, preempted);
+
+    hist_print_us(&motionLatency, "Frame to motion latency", stdout);
+    hist_print_us(&wakeupLatency, "Step wakeup latency", stdout);
+}
+
+/**
+ * @brief Signal handler requesting a clean shutdown
+ * @param sig Signal number (unused)
+ */
+void handleSignal(int sig) {
+    (void)sig;
+    running = 0;
+}
+
+/**
+ * @brief Print command line help
+ * @param prog Program name
+ */
+void printUsage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  --config FILE      Tracker list (default: one tracker on %s)\n", SERIAL_PORT);
+    printf("  --workers N        Motion worker threads (default %d, max %d)\n",
+           DEFAULT_WORKERS, MAX_WORKERS);
+    printf("  --stats N          Print statistics every N seconds, 0 = at exit only (default %d)\n",
+           DEFAULT_STATS_INTERVAL);
+    printf("  --realtime         SCHED_FIFO workers, locked memory, pinned CPUs\n");
+    printf("  --rt-priority N    Worker SCHED_FIFO priority (default %d)\n", RT_PRIORITY);
+    printf("  --cpu N            First CPU to pin the workers to (default %d)\n", RT_CPU);
+    printf("  --metrics ADDR     Metrics port on 127.0.0.1, unix socket path, or \"none\" (default %s)\n",
+           METRICS_ADDR);
+    printf("  --shm NAME         Telemetry shared-memory name, \"none\" to disable (default %s)\n",
+           TELEMETRY_SHM_NAME);
+}
+
+/**
+ * @brief Parse command line options
+ * @return 0 on success, -1 on invalid arguments
+ */
+int parseArgs(int argc, char *argv[]) {
+    static const struct option options[] = {
+        { "config",      required_argument, NULL, 'f' },
+        { "workers",     required_argument, NULL, 'w' },
+        { "stats",       required_argument, NULL, 's' },
+        { "realtime",    no_argument,       NULL, 'r' },
+        { "rt-priority", required_argument, NULL, 'p' },
+        { "cpu",         required_argument, NULL, 'c' },
+        { "shm",         required_argument, NULL, 'm' },
+        { "metrics",     required_argument, NULL, 'x' },
+        { "help",        no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "f:w:s:rp:c:m:x:h", options, NULL)) != -1) {
+        switch (opt) {
+        case 'f':
+            configPath = optarg;
+            break;
+        case 'w':
+            workerCount = atoi(optarg);
+            if (workerCount < 1 || workerCount > MAX_WORKERS) {
+                fprintf(stderr, "Error: --workers must be 1-%d\n", MAX_WORKERS);
+                return -1;
+            }
+            break;
+        case 's':
+            statsInterval = atoi(optarg);
+            if (statsInterval < 0) {
+                fprintf(stderr, "Error: invalid --stats\n");
+                return -1;
+            }
+            break;
+        case 'r':
+            rtConfig.enabled = 1;
+            break;
+        case 'p':
+            rtConfig.priority = atoi(optarg);
+            if (rtConfig.priority < 2 || rtConfig.priority > sched_get_priority_max(SCHED_FIFO)) {
+                fprintf(stderr, "Error: --rt-priority must be 2-%d\n",
+                        sched_get_priority_max(SCHED_FIFO));
+                return -1;
+            }
+            break;
+        case 'c':
+            rtConfig.cpu = atoi(optarg);
+            if (rtConfig.cpu < 0 || rtConfig.cpu >= CPU_SETSIZE) {
+                fprintf(stderr, "Error: invalid --cpu\n");
+                return -1;
+            }
+            break;
+        case 'm':
+            telemetryName = strcmp(optarg, "none") == 0 ? NULL : optarg;
+            break;
+        case 'x':
+            metricsAddr = strcmp(optarg, "none") == 0 ? NULL : optarg;
+            break;
+        default:
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
 /**
  * @brief Main control loop
  */
 int main(int argc, char *argv[]) {
-    FILE *serialInput;
-    char line[256];
+    struct epoll_event events[MAX_TRACKERS + MAX_METRICS_CLIENTS + 2];
+    struct sigaction sa;
+    struct timespec now;
+    pthread_attr_t attr;
+    int epollFd, timerFd;
+    int i;
+
+    if (parseArgs(argc, argv) < 0) {
+        return 1;
+    }
+    hist_init(&wakeupLatency);
+    hist_init(&motionLatency);
+    hist_init(&stepDuration);
+    hist_init(&stepSyscall);
+    hist_init(&controllerCompute);
 
     printf("=== Solar Tracking Motor Control ===\n");
-    printf("Opening serial port: %s\n", SERIAL_PORT);
 
-    // Open serial port for reading ESP32 commands
-    serialInput = fopen(SERIAL_PORT, "r");
-    if (!serialInput) {
-        fprintf(stderr, "Error: Cannot open serial port %s: %s\n", 
-                SERIAL_PORT, strerror(errno));
+    if (configPath) {
+        if (loadConfig(configPath) < 0) {
+            return 1;
+        }
+    } else {
+        addTracker("default", SERIAL_PORT, BAUD_RATE, findBackend("plat_drv"), DEVICE_PREFIX);
+    }
+
+    if (telemetryName) {
+        telemetryOpen();
+    }
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        perror("Error creating epoll instance");
+        telemetryClose();
         return 1;
     }
 
-    printf("Listening for sun direction commands...\n");
+    // Open every tracker; one failing link must not take down the array.
+    // A tracker without motors keeps its serial port closed until they
+    // come up, so no commands are taken that could not be carried out.
+    for (i = 0; i < trackerCount; i++) {
+        tracker_t *t = &trackers[i];
 
-    // Main control loop
-    while (1) {
-        if (fgets(line, sizeof(line), serialInput)) {
-            // Remove newline
-            line[strcspn(line, "\r\n")] = 0;
+        if (openMotors(t) < 0) {
+            publishLink(t, NULL, NULL);
+            continue;
+        }
 
-            const char *direction = parseSunDirection(line);
-            if (!direction) {
-                continue;  // Invalid command, skip
-            }
+        printf("[%s] Opening serial port: %s (%s)\n", t->name, t->serialPort, t->backend->name);
+        if (openSerial(t) == 0) {
+            struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &t->source };
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, t->serialFd, &ev);
+        }
+        publishLink(t, NULL, NULL);
+    }
+
+    if (metricsAddr) {
+        metricsListen(epollFd);
+    }
+
+    // One-second housekeeping tick: reopen lost ports, periodic statistics
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    struct itimerspec tick = { .it_interval = { 1, 0 }, .it_value = { 1, 0 } };
+    timerfd_settime(timerFd, 0, &tick, NULL);
+    static event_source_t timerSource = { SOURCE_TIMER, NULL };
+    struct epoll_event timerEv = { .events = EPOLLIN, .data.ptr = &timerSource };
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &timerEv);
 
-            printf("\nReceived direction: %s\n", direction);
+    // No SA_RESTART, so a blocking epoll_wait() returns on SIGINT/SIGTERM
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handleSignal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    if (rtConfig.enabled && setupRealtime() < 0) {
+        telemetryClose();
+        return 1;
+    }
+    if (assignAxes() < 0) {
+        fprintf(stderr, "Error: Out of memory\n");
+        telemetryClose();
+        return 1;
+    }
 
-            // Control motors based on sun direction
-            if (strcmp(direction, "Venstre") == 0) {
-                printf("Action: Rotate LEFT\n");
-                rotateStepper(STEPPER_STEPS, 0);
+    // Start the motion worker pool
+    for (i = 0; i < workerCount; i++) {
+        if (initWorkerAttr(&attr, i) < 0) {
+            telemetryClose();
+            return 1;
+        }
+        if (pthread_create(&workers[i].thread, &attr, motionWorker, &workers[i]) != 0) {
+            fprintf(stderr, "Error: Cannot start motion worker %d\n", i);
+            telemetryClose();
+            return 1;
+        }
+        pthread_attr_destroy(&attr);
+    }
 
-            } else if (strcmp(direction, "Højre") == 0 || 
-                      strcmp(direction, "Hojre") == 0) {
-                printf("Action: Rotate RIGHT\n");
-                rotateStepper(STEPPER_STEPS, 1);
+    printf("Listening for sun direction commands on %d tracker(s)...\n", trackerCount);
+    clock_gettime(CLOCK_MONOTONIC, &started);
+    int ticks = 0;
 
-            } else if (strcmp(direction, "Op") == 0) {
-                printf("Action: Tilt UP\n");
-                moveServo(SERVO_UP_ANGLE);
+    // Serial loop: parse and dispatch, never wait for a motor
+    while (running) {
+        int n = epoll_wait(epollFd, events, sizeof(events) / sizeof(events[0]), -1);
 
-            } else if (strcmp(direction, "Ned") == 0) {
-                printf("Action: Tilt DOWN\n");
-                moveServo(SERVO_DOWN_ANGLE);
+        for (i = 0; i < n; i++) {
+            event_source_t *source = events[i].data.ptr;
 
-            } else {
-                printf("Action: Unknown direction, no movement\n");
+            if (source->kind == SOURCE_METRICS_LISTEN) {
+                metricsAccept(epollFd);
+                continue;
+            }
+            if (source->kind == SOURCE_METRICS_CLIENT) {
+                metricsClientEvent(epollFd, source->owner, events[i].events);
+                continue;
+            }
+
+            if (source->kind == SOURCE_TIMER) {
+                uint64_t expirations;
+                if (read(timerFd, &expirations, sizeof(expirations)) < 0) {
+                    continue;
+                }
+
+                for (int k = 0; k < trackerCount; k++) {
+                    tracker_t *lost = &trackers[k];
+                    if (!lost->motorsUp) {
+                        if (--lost->motorRetryIn > 0 || openMotors(lost) < 0) {
+                            continue;
+                        }
+                        printf("[%s] Motors reopened\n", lost->name);
+                    }
+                    if (lost->serialFd < 0 && openSerial(lost) == 0) {
+                        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &lost->source };
+                        epoll_ctl(epollFd, EPOLL_CTL_ADD, lost->serialFd, &ev);
+                        printf("[%s] Serial port reopened\n", lost->name);
+                        publishLink(lost, NULL, NULL);
+                    }
+                    if (lost->serialFd >= 0) {
+                        reportAxes(lost);
+                    }
+                }
+
+                if (telemetry) {
+                    atomic_store_explicit(&telemetry->heartbeatNs, realtimeNs(),
+                                          memory_order_relaxed);
+                }
+
+                if (statsInterval > 0 && ++ticks >= statsInterval) {
+                    ticks = 0;
+                    clock_gettime(CLOCK_MONOTONIC, &now);
+                    printStats(timespecDiffNs(&started, &now) / 1e9);
+                }
+                continue;
+            }
+
+            tracker_t *t = source->owner;
+            if (readSerial(t) < 0 || (events[i].events & (EPOLLHUP | EPOLLERR))) {
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, t->serialFd, NULL);
+                close(t->serialFd);
+                t->serialFd = -1;
+                fprintf(stderr, "[%s] Serial port lost, retrying every second\n", t->name);
+                publishLink(t, NULL, NULL);
             }
         }
+    }
 
-        usleep(100000);  // 100ms delay between reads
+    printf("\nShutting down...\n");
+
+    // Wake the workers so they notice running == 0
+    for (i = 0; i < workerCount; i++) {
+        sem_post(&workers[i].wakeup);
+        pthread_join(workers[i].thread, NULL);
     }
 
-    fclose(serialInput);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    printStats(timespecDiffNs(&started, &now) / 1e9);
+
+    for (i = 0; i < trackerCount; i++) {
+        // Never leave stepper coils energized after an interrupted rotation
+        if (trackers[i].motorsUp && trackers[i].axes[AXIS_AZIMUTH].stepsLeft > 0) {
+            trackers[i].backend->stepper(&trackers[i], stepperRelease);
+        }
+        if (trackers[i].serialFd >= 0) {
+            close(trackers[i].serialFd);
+        }
+        trackers[i].backend->close(&trackers[i]);
+    }
+    for (i = 0; i < MAX_METRICS_CLIENTS; i++) {
+        if (metricsFd >= 0 && metricsClients[i].fd >= 0) {
+            metricsClientClose(epollFd, &metricsClients[i]);
+        }
+    }
+    if (metricsFd >= 0) {
+        close(metricsFd);
+        if (metricsAddr[0] == '/') {
+            unlink(metricsAddr);
+        }
+    }
+    close(timerFd);
+    close(epollFd);
+    telemetryClose();
     return 0;
 }
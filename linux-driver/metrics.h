@@ -0,0 +1,78 @@
+/**
+ * @file metrics.h
+ * @brief Prometheus text exposition helpers
+ * @author Yahya
+ *
+ * The hot path only ever touches relaxed atomics (see histogram.h); these
+ * helpers read them when a scrape arrives and render the Prometheus text
+ * format. Nanosecond histograms are exported with power-of-two buckets
+ * from 1 us to ~1 s, which line up exactly with the log-linear buckets.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include "histogram.h"
+
+#define METRICS_BUCKET_MIN_SHIFT 10     // First bucket: < 2^10 ns (~1 us)
+#define METRICS_BUCKET_MAX_SHIFT 30     // Last finite bucket: < 2^30 ns (~1.07 s)
+
+/**
+ * @brief Write HELP and TYPE lines for a metric family
+ * @param out Output stream
+ * @param name Metric name
+ * @param type counter, gauge or histogram
+ * @param help Description
+ */
+static inline void metrics_header(FILE *out, const char *name, const char *type, const char *help) {
+    fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/**
+ * @brief Write a nanosecond histogram as a Prometheus histogram in seconds
+ * @param out Output stream
+ * @param name Metric name (should end in _seconds)
+ * @param help Description
+ * @param h Histogram
+ */
+static inline void metrics_histogram(FILE *out, const char *name, const char *help, histogram_t *h) {
+    uint64_t cumulative = 0;
+    int idx = 0;
+
+    metrics_header(out, name, "histogram", help);
+
+    for (int shift = METRICS_BUCKET_MIN_SHIFT; shift <= METRICS_BUCKET_MAX_SHIFT; shift++) {
+        uint64_t limit = 1ULL << shift;
+
+        while (idx < HIST_BUCKETS && hist_bucket_upper(idx) < limit) {
+            cumulative += atomic_load_explicit(&h->counts[idx], memory_order_relaxed);
+            idx++;
+        }
+        fprintf(out, "%s_bucket{le=\"%.9g\"} %llu\n", name, limit / 1e9,
+                (unsigned long long)cumulative);
+    }
+
+    // Read total last so +Inf is never below a finite bucket
+    uint64_t total = atomic_load_explicit(&h->total, memory_order_relaxed);
+    if (total < cumulative) {
+        total = cumulative;
+    }
+    fprintf(out, "%s_bucket{le=\"+Inf\"} %llu\n", name, (unsigned long long)total);
+    fprintf(out, "%s_sum %.9f\n", name,
+            atomic_load_explicit(&h->sum, memory_order_relaxed) / 1e9);
+    fprintf(out, "%s_count %llu\n", name, (unsigned long long)total);
+}
+
+/**
+ * @brief Write a label value with Prometheus escaping
+ * @param out Output stream
+ * @param value Raw label value
+ */
+static inline void metrics_label(FILE *out, const char *value) {
+    for (; *value; value++) {
+        if (*value == '"' || *value == '\\') {
+            fputc('\\', out);
+        }
+        fputc(*value == '\n' ? ' ' : *value, out);
+    }
+}
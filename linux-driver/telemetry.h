@@ -0,0 +1,112 @@
+/**
+ * @file telemetry.h
+ * @brief Shared-memory telemetry layout and seqlock helpers
+ * @author Yahya
+ *
+ * The control daemon publishes the state of every tracker into a POSIX
+ * shared-memory segment. Each section has exactly one writer thread and
+ * its own sequence counter, so any number of local readers can take
+ * consistent snapshots without locks and without ever blocking the
+ * daemon: a reader that races a write simply retries.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+#define TELEMETRY_SHM_NAME "/solar-tracker"
+#define TELEMETRY_MAGIC 0x534f4c54      // "SOLT"
+#define TELEMETRY_VERSION 2
+
+/**
+ * @brief Latest serial frame and link counters (written by the serial loop)
+ */
+typedef struct {
+    _Alignas(64) atomic_uint seq;
+    uint32_t linkUp;            // Serial port open
+    uint64_t frameTimeNs;       // CLOCK_REALTIME of the latest frame
+    char line[64];              // Latest frame as received
+    char direction[16];         // Parsed sun direction
+    uint64_t frames;
+    uint64_t parseErrors;
+} telemetry_link_t;
+
+/**
+ * @brief Position and controller state of one axis (written by its worker)
+ */
+typedef struct {
+    _Alignas(64) atomic_uint seq;
+    int32_t position;           // Azimuth: net steps (clockwise positive); elevation: degrees
+    int32_t target;             // Azimuth: +1/-1 rotation direction; elevation: degrees
+    int32_t stepsLeft;          // Azimuth steps still to run, 0 when idle
+    uint32_t moving;
+    uint64_t updatedNs;         // CLOCK_REALTIME of the last change
+    uint64_t moves;             // Commands executed
+    uint64_t steps;             // Stepper steps executed
+    uint64_t coalesced;         // Commands superseded before they ran
+} telemetry_axis_t;
+
+typedef struct {
+    char name[32];
+    telemetry_link_t link;
+    telemetry_axis_t axes[2];   // Indexed by axis_id_t
+} telemetry_tracker_t;
+
+/**
+ * @brief Segment header, followed by trackerCount tracker records
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t trackerCount;
+    uint32_t pid;
+    uint64_t startedNs;         // CLOCK_REALTIME at daemon start
+    _Atomic uint64_t heartbeatNs;   // Refreshed every second while the daemon runs
+    telemetry_tracker_t trackers[];
+} telemetry_shm_t;
+
+/**
+ * @brief Segment size for a number of trackers
+ */
+static inline size_t telemetry_size(uint32_t trackerCount) {
+    return sizeof(telemetry_shm_t) + trackerCount * sizeof(telemetry_tracker_t);
+}
+
+/**
+ * @brief Open a section for writing (single writer only)
+ * @param seq Section sequence counter; odd while a write is in progress
+ */
+static inline void seqlock_write_begin(atomic_uint *seq) {
+    unsigned s = atomic_load_explicit(seq, memory_order_relaxed);
+    atomic_store_explicit(seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+/**
+ * @brief Close a section after writing
+ * @param seq Section sequence counter
+ */
+static inline void seqlock_write_end(atomic_uint *seq) {
+    unsigned s = atomic_load_explicit(seq, memory_order_relaxed);
+    atomic_store_explicit(seq, s + 1, memory_order_release);
+}
+
+/**
+ * @brief Copy a consistent snapshot of a section
+ * @param seq Section sequence counter
+ * @param dst Destination
+ * @param src Section in shared memory
+ * @param size Section size
+ */
+static inline void seqlock_read(const atomic_uint *seq, void *dst, const void *src, size_t size) {
+    unsigned before, after;
+
+    do {
+        before = atomic_load_explicit((atomic_uint *)seq, memory_order_acquire);
+        memcpy(dst, src, size);
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit((atomic_uint *)seq, memory_order_relaxed);
+    } while ((before & 1) || before != after);
+}
@@ -0,0 +1,142 @@
+/**
+ * @file telemetry_reader.c
+ * @brief Command line reader for the control daemon's shared-memory telemetry
+ * @author Yahya
+ *
+ * Maps the telemetry segment read-only and prints a consistent snapshot of
+ * every tracker. Reading never blocks or slows the daemon.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <getopt.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "telemetry.h"
+
+/**
+ * @brief Age of a CLOCK_REALTIME timestamp in seconds
+ */
+double ageSeconds(uint64_t ns) {
+    struct timespec now;
+
+    if (ns == 0) {
+        return -1.0;
+    }
+    clock_gettime(CLOCK_REALTIME, &now);
+    return ((double)now.tv_sec * 1e9 + now.tv_nsec - (double)ns) / 1e9;
+}
+
+/**
+ * @brief Print one snapshot of all trackers
+ * @param shm Mapped segment
+ */
+void printSnapshot(const telemetry_shm_t *shm) {
+    uint64_t heartbeat = atomic_load_explicit((_Atomic uint64_t *)&shm->heartbeatNs,
+                                              memory_order_relaxed);
+
+    printf("pid %u, %u trackers, up %.0f s, heartbeat %.1f s ago\n",
+           shm->pid, shm->trackerCount, ageSeconds(shm->startedNs), ageSeconds(heartbeat));
+    printf("%-16s %-4s %-8s %8s %10s %10s %8s %9s %8s %8s\n",
+           "tracker", "link", "dir", "age[s]", "frames", "errors",
+           "az[step]", "az state", "el[deg]", "coalesced");
+
+    for (uint32_t i = 0; i < shm->trackerCount; i++) {
+        const telemetry_tracker_t *t = &shm->trackers[i];
+        telemetry_link_t link;
+        telemetry_axis_t az, el;
+
+        seqlock_read(&t->link.seq, &link, &t->link, sizeof(link));
+        seqlock_read(&t->axes[0].seq, &az, &t->axes[0], sizeof(az));
+        seqlock_read(&t->axes[1].seq, &el, &t->axes[1], sizeof(el));
+
+        printf("%-16.16s %-4s %-8.8s %8.1f %10llu %10llu %8d %9s %8d %8llu\n",
+               t->name, link.linkUp ? "up" : "down",
+               link.direction[0] ? link.direction : "-",
+               ageSeconds(link.frameTimeNs),
+               (unsigned long long)link.frames, (unsigned long long)link.parseErrors,
+               az.position, az.moving ? (az.target > 0 ? "cw" : "ccw") : "idle",
+               el.position, (unsigned long long)(az.coalesced + el.coalesced));
+    }
+}
+
+/**
+ * @brief Print command line help
+ * @param prog Program name
+ */
+void printUsage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  --shm NAME     Shared-memory name (default %s)\n", TELEMETRY_SHM_NAME);
+    printf("  --watch MS     Refresh every MS milliseconds until interrupted\n");
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option options[] = {
+        { "shm",   required_argument, NULL, 'm' },
+        { "watch", required_argument, NULL, 'w' },
+        { "help",  no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    const char *name = TELEMETRY_SHM_NAME;
+    int watchMs = 0;
+    struct stat st;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "m:w:h", options, NULL)) != -1) {
+        switch (opt) {
+        case 'm':
+            name = optarg;
+            break;
+        case 'w':
+            watchMs = atoi(optarg);
+            break;
+        default:
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Cannot open %s: %s (is the daemon running?)\n",
+                name, strerror(errno));
+        return 1;
+    }
+
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(telemetry_shm_t)) {
+        fprintf(stderr, "Error: %s is not a telemetry segment\n", name);
+        close(fd);
+        return 1;
+    }
+
+    const telemetry_shm_t *shm = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shm == MAP_FAILED) {
+        perror("Error mapping telemetry segment");
+        return 1;
+    }
+
+    if (shm->magic != TELEMETRY_MAGIC || shm->version != TELEMETRY_VERSION ||
+        telemetry_size(shm->trackerCount) > (size_t)st.st_size) {
+        fprintf(stderr, "Error: %s has an unknown layout\n", name);
+        return 1;
+    }
+
+    do {
+        if (watchMs > 0) {
+            printf("\033[H\033[2J");  // Clear screen
+        }
+        printSnapshot(shm);
+        fflush(stdout);
+        if (watchMs > 0) {
+            usleep(watchMs * 1000);
+        }
+    } while (watchMs > 0);
+
+    return 0;
+}